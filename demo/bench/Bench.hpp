@@ -0,0 +1,148 @@
+/**
+  @brief Benchmarks helpers
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <profileapi.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+
+/**
+ * @brief Result of a single benchmark
+ */
+struct Result
+{
+    std::string Name;   //!< Benchmark name
+    ULONGLONG Count;    //!< Operations measured
+    double NsPerOp;     //!< Median time of an operation in nanoseconds
+};
+
+/**
+ * @brief Current time of the performance counter
+ *
+ * @return double - Time in nanoseconds
+ */
+inline double Now(void)
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return double(counter.QuadPart) * 1e9 / double(frequency.QuadPart);
+}
+
+/**
+ * @brief Measure the median time of an operation
+ *
+ * @details The operation runs Count times in each of Runs rounds, and the median
+ *          round is reported, so a preempted round does not skew the result.
+ *
+ * @tparam Body_t - Callable running a single operation
+ *
+ * @param Count - Operations per round
+ * @param Body - The measured operation
+ * @param Runs - Number of rounds (optional)
+ *
+ * @return double - Nanoseconds per operation
+ */
+template<typename Body_t>
+double Measure(ULONGLONG Count, Body_t&& Body, size_t Runs = 5)
+{
+    std::vector<double> rounds;
+    rounds.reserve(Runs);
+    for (size_t run = 0; run < Runs; ++run)
+    {
+        const double start{Now()};
+        for (ULONGLONG index = 0; index < Count; ++index)
+        {
+            Body();
+        }
+        rounds.push_back((Now() - start) / double(Count));
+    }
+    std::nth_element(rounds.begin(), rounds.begin() + Runs / 2, rounds.end());
+    return rounds[Runs / 2];
+}
+
+/**
+ * @brief Benchmarks results in JSON format
+ *
+ * @example
+ * @code {.json}
+ * {
+ *     "benchmark": "ffmock",
+ *     "hosting": "dll",
+ *     "results": [
+ *         {"name": "direct", "count": 1000000, "ns_per_op": 12.500}
+ *     ]
+ * }
+ * @endcode
+ */
+class Report
+{
+public:
+    Report(const char* Name, const char* Variant)
+        : Benchmark(Name)
+        , Hosting(Variant)
+    {
+    }
+
+    /**
+     * @brief Add result, and print it in human readable form to stderr
+     */
+    void Add(std::string Name, ULONGLONG Count, double NsPerOp)
+    {
+        fprintf(stderr, "%-32s %12llu %12.3f ns\n", Name.c_str(), Count, NsPerOp);
+        Results.push_back(Result{std::move(Name), Count, NsPerOp});
+    }
+
+    /**
+     * @brief Write the JSON report
+     *
+     * @param Output - Output stream
+     */
+    void Write(FILE* Output) const
+    {
+        fprintf(Output, "{\n    \"benchmark\": \"%s\",\n    \"hosting\": \"%s\",\n    \"results\": [",
+                Benchmark, Hosting);
+        const char* separator{"\n"};
+        for (Result const& result : Results)
+        {
+            fprintf(Output, "%s        {\"name\": \"%s\", \"count\": %llu, \"ns_per_op\": %.3f}",
+                    separator, result.Name.c_str(), result.Count, result.NsPerOp);
+            separator = ",\n";
+        }
+        fprintf(Output, "\n    ]\n}\n");
+    }
+
+private:
+    const char* Benchmark;
+    const char* Hosting;
+    std::vector<Result> Results;
+};
+
+} // namespace Bench
@@ -0,0 +1,435 @@
+/**
+  @brief ffmock benchmarks
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#include <Common.hpp>
+#include <processthreadsapi.h>
+#include <fileapi.h>
+#include <ffmock/expect.h>
+#include <ffmock/fuzz.h>
+#include <ffmock/interleave.h>
+#include <ffmock/script.h>
+#include <array>
+#include <atomic>
+#include <cwchar>
+#include <thread>
+#include "Bench.hpp"
+#include "Mocks.hpp"
+
+#if defined(FFMOCK_BENCH_DLL)
+static const char* Hosting_k{"dll"};
+#else
+static const char* Hosting_k{"static"};
+#endif
+
+//! @brief Keep the compiler from dropping the measured calls
+static volatile LSTATUS Sink;
+
+/**
+ * @brief Benchmark options
+ */
+struct Options_t
+{
+    ULONGLONG Count{1000000};   //!< Operations per round
+    unsigned Threads{std::thread::hardware_concurrency()};
+    const wchar_t* Output{};    //!< JSON output file (default to stdout)
+};
+
+/**
+ * @brief Resolving the real API on the first call of a mock
+ *
+ * @details Must run first, before anything calls RegDeleteValueW.
+ */
+static void FirstCall(Bench::Report& Report)
+{
+    Report.Add("first_call", 1, Bench::Measure(1, []{ Sink = RegDeleteValueW(nullptr, L""); }, 1));
+    Report.Add("second_call", 1, Bench::Measure(1, []{ Sink = RegDeleteValueW(nullptr, L""); }, 1));
+}
+
+/**
+ * @brief Pass-through and guarded calls compared with calling the real API
+ */
+static void Calls(Bench::Report& Report, Options_t const& Options)
+{
+    using RegCloseKey_t = LSTATUS(APIENTRY*)(HKEY);
+    static const RegCloseKey_t real{reinterpret_cast<RegCloseKey_t>(
+        GetProcAddress(GetModuleHandleW(L"advapi32.dll"), "RegCloseKey"))};
+
+    Report.Add("direct", Options.Count, Bench::Measure(Options.Count, []{ Sink = real(nullptr); }));
+    Report.Add("pass_through", Options.Count, Bench::Measure(Options.Count, []{ Sink = RegCloseKey(nullptr); }));
+
+    Mocks::FFRegCloseKey::Guard guard([](HKEY) -> LSTATUS { return ERROR_SUCCESS; });
+    Report.Add("guarded_lambda", Options.Count, Bench::Measure(Options.Count, []{ Sink = RegCloseKey(nullptr); }));
+
+    using Step = ffmock::Step<Mocks::FFRegCloseKey>;
+    static constexpr std::array<Step, 3> steps{{{ERROR_SUCCESS}, {ERROR_SUCCESS}, {ERROR_INVALID_HANDLE}}};
+    ffmock::Script script(steps, ffmock::Exhausted::Cycle);
+    guard.Set(std::ref(script));
+    Report.Add("guarded_script", Options.Count, Bench::Measure(Options.Count, []{ Sink = RegCloseKey(nullptr); }));
+
+    // A fuzzing iteration: reset the input, then decide the call
+    using Outcome = ffmock::fuzz::Outcome<Mocks::FFRegCloseKey>;
+    static constexpr std::array<Outcome, 2> outcomes{{{ERROR_SUCCESS}, {ERROR_INVALID_HANDLE}}};
+    static const BYTE data[]{1};
+    static ffmock::fuzz::Input input;
+    ffmock::fuzz::Decider decider(input, outcomes);
+    guard.Set(std::ref(decider));
+    Report.Add("guarded_fuzz", Options.Count, Bench::Measure(Options.Count, []
+        {
+            input.Reset(data, sizeof(data));
+            Sink = RegCloseKey(nullptr);
+        }));
+}
+
+/**
+ * @brief Thousands of calls verified against expectations
+ *
+ * @details GmockBench.cpp runs the same workload on gmock.
+ */
+static void ExpectCalls(Bench::Report& Report, Options_t const& Options)
+{
+    const ULONG count{ULONG(Options.Count / 100 + 1)};
+    Report.Add("expect_call", count, Bench::Measure(1, [count]
+        {
+            using namespace ffmock::expect;
+            auto expected = Expect<Mocks::FFRegCloseKey>(
+                Call(HKEY_CURRENT_USER).Times(0),
+                Call(HKEY_LOCAL_MACHINE).Times(count).Return(ERROR_SUCCESS));
+            Mocks::FFRegCloseKey::Guard guard(std::ref(expected));
+            for (ULONG index = 0; index < count; ++index)
+            {
+                Sink = RegCloseKey(HKEY_LOCAL_MACHINE);
+            }
+            Sink = expected.Verify() ? ERROR_SUCCESS : ERROR_INVALID_DATA;
+        }) / double(count));
+}
+
+/**
+ * @brief Guard construction and destruction
+ */
+static void Guards(Bench::Report& Report, Options_t const& Options)
+{
+    Report.Add("guard_default", Options.Count, Bench::Measure(Options.Count, []
+        {
+            Mocks::FFRegCloseKey::Guard guard;
+        }));
+    Report.Add("guard_lambda", Options.Count, Bench::Measure(Options.Count, []
+        {
+            Mocks::FFRegCloseKey::Guard guard([](HKEY) -> LSTATUS { return ERROR_SUCCESS; });
+        }));
+}
+
+/**
+ * @brief Threads calling the same guarded mock while guards toggle
+ *
+ * @details Guards of the called mock are nested and destroyed while the threads
+ *          call, so each call races the replacement and restoring of its target.
+ */
+static void Contention(Bench::Report& Report, Options_t const& Options)
+{
+    for (unsigned threads = 1; threads <= Options.Threads; threads *= 2)
+    {
+        Mocks::FFRegCloseKey::Guard guard([](HKEY) -> LSTATUS { return ERROR_SUCCESS; });
+        std::atomic<unsigned> ready{};
+        std::atomic<bool> done{};
+        std::vector<double> nsPerCall(threads);
+        std::vector<std::thread> callers;
+        for (unsigned thread = 0; thread < threads; ++thread)
+        {
+            callers.emplace_back([&, thread]
+                {
+                    ready.fetch_add(1);
+                    while (ready.load() < threads)
+                    {
+                        SwitchToThread();
+                    }
+                    nsPerCall[thread] = Bench::Measure(Options.Count, []{ Sink = RegCloseKey(nullptr); }, 1);
+                    if (ready.fetch_add(1) == 2 * threads - 1)
+                    {
+                        done.store(true);
+                    }
+                });
+        }
+
+        ULONGLONG toggles{};
+        const double start{Bench::Now()};
+        while (!done.load())
+        {
+            Mocks::FFRegCloseKey::Guard toggle([](HKEY) -> LSTATUS { return ERROR_SUCCESS; });
+            ++toggles;
+        }
+        const double elapsed{Bench::Now() - start};
+        for (std::thread& caller : callers)
+        {
+            caller.join();
+        }
+
+        double total{};
+        for (double ns : nsPerCall)
+        {
+            total += ns;
+        }
+        Report.Add("contention_" + std::to_string(threads), Options.Count * threads, total / threads);
+        Report.Add("contention_" + std::to_string(threads) + "_guard", toggles, elapsed / double(toggles ? toggles : 1));
+    }
+}
+
+/**
+ * @brief Write and read 4KB blocks of a file
+ *
+ * @details Blocks cycle over the first 1MB of the file, at offsets given by
+ *          OVERLAPPED on a synchronous handle.
+ */
+static void FileBlocks(Bench::Report& Report, ULONGLONG Count, std::string Prefix, PCWSTR Name)
+{
+    HANDLE file{CreateFileW(Name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        UserErrorMessage(L"Failed creating benchmark file");
+        return;
+    }
+
+    static BYTE block[ffmock::memfs::Page_k];
+    ULONGLONG index{};
+    auto transfer = [&](bool Write)
+        {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = DWORD(index++ % 256 * sizeof(block));
+            DWORD transferred;
+            Sink = Write ? WriteFile(file, block, sizeof(block), &transferred, &overlapped) :
+                           ReadFile(file, block, sizeof(block), &transferred, &overlapped);
+        };
+    Report.Add(Prefix + "_write_4k", Count, Bench::Measure(Count, [&]{ transfer(true); }));
+    index = 0;
+    Report.Add(Prefix + "_read_4k", Count, Bench::Measure(Count, [&]{ transfer(false); }));
+    CloseHandle(file);
+}
+
+/**
+ * @brief In-memory filesystem compared with a temporary file
+ */
+static void Files(Bench::Report& Report, Options_t const& Options)
+{
+    const ULONGLONG count{Options.Count / 16 + 1};
+    {
+        ffmock::memfs::FileSystem fs;
+        Mocks::FileSystemMount mount(fs);
+        FileBlocks(Report, count, "memfs", L"C:\\ffmock\\bench.bin");
+    }
+    {
+        // Overlapped reads completed through a simulated completion port
+        ffmock::memfs::FileSystem fs;
+        ffmock::async::Engine io;
+        Mocks::AsyncMount mount(fs, io);
+        fs.Store(L"C:\\ffmock\\bench.bin", std::string(256 * ffmock::memfs::Page_k, '\0'));
+        HANDLE file{CreateFileW(L"C:\\ffmock\\bench.bin", GENERIC_READ, 0, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_OVERLAPPED, nullptr)};
+        HANDLE port{CreateIoCompletionPort(file, nullptr, 0, 0)};
+        static BYTE block[ffmock::memfs::Page_k];
+        OVERLAPPED overlapped{};
+        ULONGLONG index{};
+        Report.Add("async_read_4k", count, Bench::Measure(count, [&]
+            {
+                overlapped.Offset = DWORD(index++ % 256 * sizeof(block));
+                ReadFile(file, block, sizeof(block), nullptr, &overlapped);
+                DWORD bytes;
+                ULONG_PTR key;
+                LPOVERLAPPED completed;
+                Sink = GetQueuedCompletionStatus(port, &bytes, &key, &completed, INFINITE);
+            }));
+        CloseHandle(port);
+        CloseHandle(file);
+    }
+
+    wchar_t directory[MAX_PATH + 1];
+    wchar_t name[MAX_PATH + 1];
+    if (!GetTempPathW(ARRAYSIZE(directory), directory) ||
+        !GetTempFileNameW(directory, L"ffm", 0, name))
+    {
+        UserErrorMessage(L"Failed creating temporary file name");
+        return;
+    }
+    FileBlocks(Report, count, "tempfile", name);
+}
+
+/**
+ * @brief Send and receive 4KB messages over an in-memory connection
+ */
+static void Sockets(Bench::Report& Report, Options_t const& Options)
+{
+    const ULONGLONG count{Options.Count / 16 + 1};
+    ffmock::sockets::Network net;
+    Mocks::NetworkMount mount(net);
+    SOCKET listener{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(8080);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener, 1);
+    SOCKET client{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+    connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    SOCKET server{accept(listener, nullptr, nullptr)};
+
+    static char message[ffmock::memfs::Page_k];
+    Report.Add("memsocket_send_recv_4k", count, Bench::Measure(count, [&]
+        {
+            send(client, message, sizeof(message), 0);
+            Sink = recv(server, message, sizeof(message), 0);
+        }));
+    closesocket(server);
+    closesocket(client);
+    closesocket(listener);
+}
+
+static DWORD WINAPI Nothing(LPVOID)
+{
+    return 0;
+}
+
+/**
+ * @brief Create and join short-lived threads, then the same on a worker pool
+ */
+static void Threads(Bench::Report& Report, Options_t const& Options)
+{
+    const ULONGLONG count{Options.Count / 256 + 1};
+    auto spawn = []
+        {
+            HANDLE thread{CreateThread(nullptr, 0, Nothing, nullptr, 0, nullptr)};
+            Sink = LSTATUS(WaitForSingleObject(thread, INFINITE));
+            CloseHandle(thread);
+        };
+    Report.Add("thread_create_join", count, Bench::Measure(count, spawn));
+
+    ffmock::threads::Pool pool;
+    Mocks::ThreadPoolMount mount(pool);
+    Report.Add("pooled_create_join", count, Bench::Measure(count, spawn));
+}
+
+/**
+ * @brief Acquire and release an uncontended lock, then the same under the contention profiler
+ */
+static void Locks(Bench::Report& Report, Options_t const& Options)
+{
+    static SRWLOCK lock = SRWLOCK_INIT;
+    auto cycle = []
+        {
+            AcquireSRWLockExclusive(&lock);
+            ReleaseSRWLockExclusive(&lock);
+        };
+    Report.Add("srw_acquire_release", Options.Count, Bench::Measure(Options.Count, cycle));
+
+    ffmock::contention::Profiler profiler;
+    Mocks::ContentionMount mount(profiler);
+    Report.Add("profiled_acquire_release", Options.Count, Bench::Measure(Options.Count, cycle));
+}
+
+/**
+ * @brief Mocked calls as scheduling points of two interleaved threads
+ */
+static void Interleaving(Bench::Report& Report, Options_t const& Options)
+{
+    const ULONGLONG count{Options.Count / 100 + 1};
+    auto calls = [count]
+        {
+            for (ULONGLONG index = 0; index < count; ++index)
+            {
+                Sink = RegCloseKey(nullptr);
+            }
+        };
+    ffmock::interleave::Random strategy(1);
+    ffmock::interleave::Scheduler scheduler(strategy);
+    Report.Add("interleaved_call", count * 2, Bench::Measure(1, [&]
+        {
+            scheduler.Run({calls, calls});
+        }) / double(count * 2));
+
+    // Schedules of a few calls per thread, as explored by a test
+    auto few = []
+        {
+            for (int index = 0; index < 4; ++index)
+            {
+                Sink = RegCloseKey(nullptr);
+            }
+        };
+    Report.Add("explored_schedule", count, Bench::Measure(count, [&]
+        {
+            scheduler.Run({few, few});
+        }, 1));
+}
+
+/**
+ * @brief Benchmarks entrypoint
+ *
+ * @param argc - Count of command line arguments
+ * @param argv - Command line arguments strings
+ *               --count N   - Operations per round
+ *               --threads N - Maximum number of contending threads
+ *               --output F  - JSON output file
+ *
+ * @return int - 0 if successful
+ */
+int wmain(_In_ int argc, _In_ wchar_t* argv[])
+{
+    Options_t options;
+    for (int arg = 1; arg + 1 < argc; arg += 2)
+    {
+        if (!wcscmp(argv[arg], L"--count"))
+        {
+            options.Count = wcstoull(argv[arg + 1], nullptr, 10);
+        }
+        else if (!wcscmp(argv[arg], L"--threads"))
+        {
+            options.Threads = wcstoul(argv[arg + 1], nullptr, 10);
+        }
+        else if (!wcscmp(argv[arg], L"--output"))
+        {
+            options.Output = argv[arg + 1];
+        }
+    }
+
+    Bench::Report report("ffmock", Hosting_k);
+    FirstCall(report);
+    Calls(report, options);
+    Guards(report, options);
+    ExpectCalls(report, options);
+    Contention(report, options);
+    Files(report, options);
+    Sockets(report, options);
+    Threads(report, options);
+    Locks(report, options);
+    Interleaving(report, options);
+
+    FILE* output{stdout};
+    if (options.Output && _wfopen_s(&output, options.Output, L"w"))
+    {
+        UserErrorMessage(L"Failed opening output file", ERROR_OPEN_FAILED);
+        return ERROR_OPEN_FAILED;
+    }
+    report.Write(output);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
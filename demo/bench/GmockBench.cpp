@@ -0,0 +1,115 @@
+/**
+  @brief Expectations benchmark on gmock, for comparison with FFmockBench
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#include <Common.hpp>
+#include <winreg.h>
+#include <gmock/gmock.h>
+#include <cwchar>
+#include "Bench.hpp"
+
+//! @brief Keep the compiler from dropping the measured calls
+static volatile LSTATUS Sink;
+
+/**
+ * @brief Registry API wrapped in an interface, as gmock requires for free functions
+ */
+class RegistryApi
+{
+public:
+    virtual ~RegistryApi(void) = default;
+    virtual LSTATUS CloseKey(HKEY Key) = 0;
+};
+
+class MockRegistryApi : public RegistryApi
+{
+public:
+    MOCK_METHOD(LSTATUS, CloseKey, (HKEY Key), (override));
+};
+
+/**
+ * @brief Thousands of calls verified against expectations (same workload as FFmockBench)
+ */
+static void ExpectCalls(Bench::Report& Report, ULONGLONG Count)
+{
+    const ULONG count{ULONG(Count / 100 + 1)};
+    Report.Add("expect_call", count, Bench::Measure(1, [count]
+        {
+            MockRegistryApi mock;
+            EXPECT_CALL(mock, CloseKey(HKEY_CURRENT_USER)).Times(0);
+            EXPECT_CALL(mock, CloseKey(HKEY_LOCAL_MACHINE))
+                .Times(int(count))
+                .WillRepeatedly(::testing::Return(ERROR_SUCCESS));
+            RegistryApi& api{mock};
+            for (ULONG index = 0; index < count; ++index)
+            {
+                Sink = api.CloseKey(HKEY_LOCAL_MACHINE);
+            }
+            Sink = ::testing::Mock::VerifyAndClearExpectations(&mock) ? ERROR_SUCCESS : ERROR_INVALID_DATA;
+        }) / double(count));
+}
+
+/**
+ * @brief Benchmark entrypoint
+ *
+ * @param argc - Count of command line arguments
+ * @param argv - Command line arguments strings
+ *               --count N   - Operations per round (as FFmockBench)
+ *               --output F  - JSON output file
+ *
+ * @return int - 0 if successful
+ */
+int wmain(_In_ int argc, _In_ wchar_t* argv[])
+{
+    ::testing::InitGoogleMock(&argc, argv);
+
+    ULONGLONG count{1000000};
+    const wchar_t* path{};
+    for (int arg = 1; arg + 1 < argc; arg += 2)
+    {
+        if (!wcscmp(argv[arg], L"--count"))
+        {
+            count = wcstoull(argv[arg + 1], nullptr, 10);
+        }
+        else if (!wcscmp(argv[arg], L"--output"))
+        {
+            path = argv[arg + 1];
+        }
+    }
+
+    Bench::Report report("gmock", "interface");
+    ExpectCalls(report, count);
+
+    FILE* output{stdout};
+    if (path && _wfopen_s(&output, path, L"w"))
+    {
+        UserErrorMessage(L"Failed opening output file", ERROR_OPEN_FAILED);
+        return ERROR_OPEN_FAILED;
+    }
+    report.Write(output);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+  @brief libFuzzer harness of the demo Registry class
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#include <Registry.hpp>
+#include <ffmock/fuzz.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include "Mocks.hpp"
+
+using CreateOutcome = ffmock::fuzz::Outcome<Mocks::FFRegCreateKeyExW>;
+using SetOutcome = ffmock::fuzz::Outcome<Mocks::FFRegSetValueExW>;
+using CloseOutcome = ffmock::fuzz::Outcome<Mocks::FFRegCloseKey>;
+
+/**
+ * @brief Write a key handle, and the disposition, chosen by the input
+ *
+ * @details The key is never passed to the real APIs, since all its uses are mocked.
+ */
+static void CreatedKey(ffmock::fuzz::Input& Source, HKEY, LPCWSTR, DWORD, LPWSTR, DWORD, REGSAM,
+                       LPSECURITY_ATTRIBUTES, PHKEY Result, LPDWORD Disposition)
+{
+    *Result = reinterpret_cast<HKEY>(Source.Take<ULONG_PTR>() | 4);
+    if (Disposition)
+    {
+        *Disposition = Source.Take<BYTE>() & 1 ? REG_CREATED_NEW_KEY : REG_OPENED_EXISTING_KEY;
+    }
+}
+
+//! @brief Results of RegCreateKeyExW() (the first is taken once the input is exhausted)
+static constexpr std::array<CreateOutcome, 5> CreateOutcomes{{
+    {ERROR_SUCCESS, NO_ERROR, CreatedKey},
+    CreateOutcome::Failure(),
+    {ERROR_ACCESS_DENIED},
+    {ERROR_PATH_NOT_FOUND},
+    {ERROR_NOT_ENOUGH_MEMORY}}};
+
+//! @brief Results of RegSetValueExW()
+static constexpr std::array<SetOutcome, 5> SetOutcomes{{
+    {ERROR_SUCCESS},
+    SetOutcome::Failure(),
+    {ERROR_ACCESS_DENIED},
+    {ERROR_INVALID_HANDLE},
+    {ERROR_KEY_DELETED}}};
+
+//! @brief Results of RegCloseKey()
+static constexpr std::array<CloseOutcome, 2> CloseOutcomes{{
+    {ERROR_SUCCESS},
+    CloseOutcome::Failure()}};
+
+//! @brief Bytes of the current iteration, shared by all the mocks
+static ffmock::fuzz::Input Source;
+
+/**
+ * @brief Set the mocks once for the whole session
+ *
+ * @return int - 0 if successful
+ */
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+    static ffmock::fuzz::Decider create(Source, CreateOutcomes);
+    static ffmock::fuzz::Decider set(Source, SetOutcomes);
+    static ffmock::fuzz::Decider close(Source, CloseOutcomes);
+    static Mocks::FFRegCreateKeyExW::Guard createGuard(std::ref(create));
+    static Mocks::FFRegSetValueExW::Guard setGuard(std::ref(set));
+    static Mocks::FFRegCloseKey::Guard closeGuard(std::ref(close));
+
+    // Failures are expected, don't print them
+    std::wcerr.setstate(std::ios::badbit);
+    return 0;
+}
+
+/**
+ * @brief Create a key and add a value, with the input deciding the APIs results
+ *
+ * @param Data - Fuzzer input
+ * @param Size - Count of input bytes
+ *
+ * @return int - Always 0
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size)
+{
+    Source.Reset(Data, Size);
+    Registry registry;
+    if (registry.Create(L"Software\\_DeleteMe_"))
+    {
+        registry.AddStringValue(L"Fuzzed", L"Value", Source.Take<BYTE>() & 1 ? REG_EXPAND_SZ : REG_SZ);
+    }
+    return 0;
+}
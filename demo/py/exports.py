@@ -26,7 +26,7 @@ import re
 import subprocess
 import argparse
 
-EXPORTED_SYMBOLS_RE = re.compile(r'\s(\?(RealAPI|MockAPI)[^\s]+)\s')
+EXPORTED_SYMBOLS_RE = re.compile(r'\s(\?(State|Entries|Count|Current)[^\s]+)\s')
 
 def main():
     parser = argparse.ArgumentParser(allow_abbrev=False)
@@ -41,7 +41,7 @@ def main():
     results = subprocess.run(['dumpbin.exe', '/symbols', args.input], capture_output=True, text=True)
 
     exports = []
-    # find symbols for MockAPI and RealAPI
+    # find symbols for the mocks and the mock registry
     for line in results.stdout.split('\n'):
         match = re.search(EXPORTED_SYMBOLS_RE, line)
         if match:
@@ -0,0 +1,121 @@
+'''
+    Compile-time benchmark of mocks declarations
+'''
+
+# Copyright (C) 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+import os
+import json
+import time
+import subprocess
+import argparse
+
+# All generated APIs share the same signature, return value and last error,
+# so mocks are only told apart by the API identity
+API_ARGS = '(_In_ HKEY Key, _In_opt_ LPCWSTR SubKey, _Out_ PHKEY Result)'
+API_CALL = '(Key, SubKey, Result)'
+API_ERRORS = 'LSTATUS, ERROR_REGISTRY_IO_FAILED, NO_ERROR'
+
+def api_name(index):
+    return f'BenchApi{index:05}'
+
+def generate(count):
+    '''
+        Generate a mocks source file with count mocked APIs
+    '''
+    lines = ['#include <windows.h>',
+             '#include <ffmock/ffmock.h>',
+             '',
+             'extern "C"',
+             '{']
+    for index in range(count):
+        lines.append(f'FFMOCK_IMPORT LSTATUS APIENTRY {api_name(index)}{API_ARGS};')
+    lines += ['}',
+              '',
+              'namespace Bench',
+              '{']
+    for index in range(count):
+        lines.append(f'DECLARE_MOCK({api_name(index)}, {API_ERRORS}, APIENTRY, {API_ARGS});')
+    lines += ['}',
+              '',
+              'static HMODULE Module{GetModuleHandleW(nullptr)};',
+              '',
+              'DEFINE_MOCK_REGISTRY();']
+    for index in range(count):
+        lines.append(f'DEFINE_GUARD(Bench, {api_name(index)});')
+        lines.append(f'DEFINE_MOCK({api_name(index)}, {API_ERRORS});')
+    lines += ['',
+              'extern "C"',
+              '{']
+    for index in range(count):
+        name = api_name(index)
+        lines.append(f'FFMOCK_IMPORT LSTATUS APIENTRY {name}{API_ARGS}')
+        lines.append(f'{{ static Bench::FF{name} mock(Module); return mock{API_CALL}; }}')
+    lines += ['}', '']
+    return '\n'.join(lines)
+
+def measure(args, count):
+    '''
+        Compile the generated source returning build time and object size
+    '''
+    source = os.path.join(args.directory, f'mocks{count}.cpp')
+    target = os.path.join(args.directory, f'mocks{count}.obj')
+    with open(source, 'w') as file:
+        file.write(generate(count))
+
+    command = [args.compiler, '/nologo', '/c', '/std:c++17', '/EHsc', '/GR-', '/W4', '/bigobj',
+               '/DFFMOCK_IMPORT=', f'/I{args.include}', f'/Fo{target}', source] + args.flags
+    start = time.perf_counter()
+    results = subprocess.run(command, capture_output=True, text=True)
+    seconds = time.perf_counter() - start
+    if results.returncode:
+        print(results.stdout)
+        raise RuntimeError(f'Failed compiling {count} mocks')
+
+    return {'mocks': count,
+            'seconds': round(seconds, 3),
+            'object_bytes': os.path.getsize(target),
+            'bytes_per_mock': os.path.getsize(target) // count}
+
+def main():
+    parser = argparse.ArgumentParser(allow_abbrev=False)
+
+    # General options
+    parser.add_argument('-n', '--counts', type=int, nargs='+', default=[1000, 5000],
+                        help='Numbers of mocks to generate')
+    parser.add_argument('-c', '--compiler', default='cl.exe', help='Compiler executable')
+    parser.add_argument('-i', '--include', default=os.path.join(os.path.dirname(__file__), '..', '..', 'inc'),
+                        help='ffmock include directory')
+    parser.add_argument('-d', '--directory', default='.', help='Directory for generated files')
+    parser.add_argument('-f', '--flags', nargs='*', default=[], help='Additional compiler flags')
+    parser.add_argument('-o', '--output', help='Output JSON file')
+
+    args = parser.parse_args()
+
+    results = [measure(args, count) for count in args.counts]
+    report = json.dumps({'benchmark': 'mocks compile time', 'results': results}, indent=4)
+    print(report)
+    if args.output:
+        with open(args.output, 'w') as file:
+            file.write(report)
+
+if __name__ == '__main__':
+    main()
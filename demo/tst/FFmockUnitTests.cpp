@@ -25,9 +25,23 @@
 #include <gtest/gtest.h>
 #include <Registry.hpp>
 #include <psapi.h>
+#include <crtdbg.h>
 #include <winuser.h>
 #include <thread>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <ffmock/control.h>
+#include <ffmock/expect.h>
+#include <ffmock/fuzz.h>
+#include <ffmock/interleave.h>
+#include <ffmock/reload.h>
+#include <ffmock/rendezvous.h>
+#include <ffmock/script.h>
 #include "Mocks.hpp"
 
 /******************************************************
@@ -68,6 +82,1301 @@ TEST_F(RegistryTestSuite, Test_Create)
     ASSERT_TRUE(Create(L"Software\\_DeleteMe_"));
 }
 
+//! @brief Time to wait for a call to park in a rendezvous
+static constexpr DWORD RendezvousTimeout_k{10000};
+
+TEST_F(RegistryTestSuite, Test_Open_Rendezvous)
+{
+    std::thread opener;
+    {
+        ffmock::Rendezvous<Mocks::FFRegOpenKeyW> rendezvous;
+
+        opener = std::thread([this]
+            {
+                EXPECT_FALSE(Open(L"Software\\Microsoft"));
+            });
+        auto call = rendezvous.Wait(RendezvousTimeout_k);
+        EXPECT_TRUE(call);
+        if (call)
+        {
+            EXPECT_EQ(call->Arg<0>(), HKEY_LOCAL_MACHINE);
+            EXPECT_STREQ(call->Arg<1>(), L"Software\\Microsoft");
+            call->Release(ERROR_ACCESS_DENIED);
+        }
+    }
+    opener.join();
+    ASSERT_FALSE(Key);
+}
+
+/******************************************************
+ * @brief Rendezvous mock unit tests
+ *
+ * @details Mocks are cleared and parked calls released
+ *          before the calling threads are joined.
+ ******************************************************/
+TEST(RendezvousTestSuite, Test_Destroy_Parked)
+{
+    LSTATUS status{};
+    std::thread deleter;
+    {
+        ffmock::Rendezvous<Mocks::FFRegDeleteValueW> rendezvous;
+
+        deleter = std::thread([&status]
+            {
+                status = RegDeleteValueW(HKEY_LOCAL_MACHINE, L"Parked");
+            });
+        // Left parked, the rendezvous fails the call before it is destroyed
+        EXPECT_TRUE(rendezvous.Wait(RendezvousTimeout_k));
+    }
+    deleter.join();
+    EXPECT_EQ(status, Mocks::FFRegDeleteValueW::Error_k);
+    EXPECT_EQ(RegDeleteValueW(HKEY_LOCAL_MACHINE, L"Parked"), ERROR_FILE_NOT_FOUND);
+}
+
+TEST(RendezvousTestSuite, Test_Release_Out_Of_Order)
+{
+    LSTATUS first{}, second{};
+    bool firstArrived{};
+    std::thread deleteFirst, deleteSecond;
+    {
+        ffmock::Rendezvous<Mocks::FFRegDeleteValueW> rendezvous;
+
+        deleteFirst = std::thread([&first]
+            {
+                first = RegDeleteValueW(HKEY_LOCAL_MACHINE, L"First");
+            });
+        deleteSecond = std::thread([&second]
+            {
+                second = RegDeleteValueW(HKEY_LOCAL_MACHINE, L"Second");
+            });
+
+        // Both calls are parked at once, release them in reverse order of arrival
+        auto arrived = rendezvous.Wait(RendezvousTimeout_k);
+        auto next = rendezvous.Wait(RendezvousTimeout_k);
+        EXPECT_TRUE(arrived && next);
+        if (arrived && next)
+        {
+            firstArrived = !wcscmp(arrived->Arg<1>(), L"First");
+            next->Release(ERROR_FILE_NOT_FOUND);
+            arrived->Release(ERROR_ACCESS_DENIED);
+        }
+    }
+    deleteFirst.join();
+    deleteSecond.join();
+
+    EXPECT_EQ(first, firstArrived ? ERROR_ACCESS_DENIED : ERROR_FILE_NOT_FOUND);
+    EXPECT_EQ(second, firstArrived ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+}
+
+/******************************************************
+ * @brief Scripted mock unit tests
+ ******************************************************/
+TEST_F(RegistryTestSuite, Test_Open_Script)
+{
+    using Step = ffmock::Step<Mocks::FFRegOpenKeyW>;
+    static constexpr std::array<Step, 4> steps{{
+        Step::Real(),
+        Step::Real(),
+        {ERROR_REGISTRY_IO_FAILED},
+        {ERROR_SUCCESS, NO_ERROR, [](HKEY, LPCWSTR, PHKEY Result) { *Result = nullptr; }}}};
+
+    ffmock::Script script(steps, ffmock::Exhausted::Real);
+    Mocks::FFRegOpenKeyW::Guard guard(std::ref(script));
+    ASSERT_TRUE(Open(L"Software\\Microsoft"));
+    ASSERT_TRUE(Open(L"Software\\Microsoft"));
+    ASSERT_FALSE(Open(L"Software\\Microsoft"));
+    HKEY key{HKEY_LOCAL_MACHINE};
+    ASSERT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+    ASSERT_EQ(key, nullptr);
+    ASSERT_TRUE(script.Done());
+    ASSERT_TRUE(Open(L"Software\\Microsoft"));
+}
+
+TEST(ScriptTestSuite, Test_Concurrent_Steps)
+{
+    using Step = ffmock::Step<Mocks::FFRegDeleteValueW>;
+    constexpr size_t count{64};
+    static constexpr std::array<Step, count> steps{[]
+        {
+            std::array<Step, count> table{};
+            for (size_t index = 0; index < count; ++index)
+            {
+                table[index].Value = LSTATUS(index + 1);
+            }
+            return table;
+        }()};
+
+    ffmock::Script script(steps, ffmock::Exhausted::Cycle);
+    Mocks::FFRegDeleteValueW::Guard guard(std::ref(script));
+    std::atomic<ULONGLONG> taken[count + 1]{};
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < 4; ++thread)
+    {
+        threads.emplace_back([&taken]
+            {
+                for (size_t call = 0; call < count; ++call)
+                {
+                    taken[RegDeleteValueW(HKEY_LOCAL_MACHINE, L"_DeleteMe_")]++;
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Each step was taken once per cycle
+    EXPECT_EQ(script.Taken(), 4 * count);
+    EXPECT_EQ(taken[0].load(), 0u);
+    for (size_t index = 1; index <= count; ++index)
+    {
+        EXPECT_EQ(taken[index].load(), 4u);
+    }
+}
+
+/******************************************************
+ * @brief Global mock registry unit tests
+ *
+ * @details The registry is reset after each test by
+ *          MockRegistryListener (see wmain).
+ ******************************************************/
+TEST_F(RegistryTestSuite, Test_Reset_All)
+{
+    Mocks::FFRegOpenKeyW::Guard guard;
+    ASSERT_TRUE(Mocks::FFRegOpenKeyW::Active());
+    ASSERT_FALSE(Open(L"Software\\Microsoft"));
+
+    // Guards set before the reset pass calls through to the real API
+    ffmock::MockRegistry::ResetAll();
+    ASSERT_FALSE(Mocks::FFRegOpenKeyW::Active());
+    ASSERT_TRUE(Open(L"Software\\Microsoft"));
+}
+
+TEST_F(RegistryTestSuite, Test_Snapshot)
+{
+    ffmock::MockRegistry::Snapshot saved;
+    {
+        Mocks::FFRegOpenKeyW::Guard guard;
+        saved = ffmock::MockRegistry::Save();
+    }
+    ASSERT_TRUE(Open(L"Software\\Microsoft"));
+
+    ffmock::MockRegistry::Restore(saved);
+    ASSERT_TRUE(Mocks::FFRegOpenKeyW::Active());
+    ASSERT_FALSE(Open(L"Software\\Microsoft"));
+}
+
+TEST(MockRegistryTestSuite, Test_Enumerate)
+{
+    Mocks::FFRegDeleteValueW::Guard guard;
+    std::set<std::string> names;
+    ffmock::MockRegistry::Enumerate([&names](ffmock::MockRegistry::Info const& Mock)
+        {
+            names.insert(Mock.Name);
+            EXPECT_EQ(Mock.Active, !strcmp(Mock.Name, "RegDeleteValueW"));
+        });
+    for (const char* name : {"RegCloseKey", "RegCreateKeyW", "RegCreateKeyExW",
+                             "RegDeleteValueW", "RegOpenKeyW", "RegSetValueExW"})
+    {
+        EXPECT_EQ(names.count(name), 1u) << name;
+    }
+}
+
+TEST(MockRegistryTestSuite, Test_Identity)
+{
+    // Mocks of APIs with the same signature are distinct instances
+    static_assert(!std::is_same<Mocks::FFRegOpenKeyW::Mock_t, Mocks::FFRegCreateKeyW::Mock_t>::value,
+                  "Mocks must not share state");
+    EXPECT_EQ(Mocks::FFRegOpenKeyW::Id_k, ffmock::Identity("RegOpenKeyW"));
+    EXPECT_NE(Mocks::FFRegOpenKeyW::Id_k, Mocks::FFRegCreateKeyW::Id_k);
+    // Mangled APIs are identified by their name, not the name they are mangled to
+    EXPECT_EQ(Mocks::FFCreateFileW::Id_k, ffmock::Identity("CreateFileW"));
+}
+
+TEST(MockRegistryTestSuite, Test_Handle_Failure)
+{
+    // The default failure of a HANDLE mock can be INVALID_HANDLE_VALUE
+    Mocks::FFCreateFileW::Guard guard;
+    EXPECT_EQ(CreateFileW(L"C:\\Data\\File.bin", GENERIC_READ, 0, nullptr,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr), INVALID_HANDLE_VALUE);
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_FILE_NOT_FOUND));
+}
+
+/******************************************************
+ * @brief In-memory filesystem unit tests
+ ******************************************************/
+TEST(MemFsTestSuite, Test_Read_Write)
+{
+    ffmock::memfs::FileSystem fs;
+    Mocks::FileSystemMount mount(fs);
+
+    // Span several pages
+    std::string data(3 * ffmock::memfs::Page_k + 100, 'x');
+    data[ffmock::memfs::Page_k] = 'y';
+    HANDLE file{CreateFileW(L"C:\\Data\\File.bin", GENERIC_WRITE, 0, nullptr,
+                            CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    ASSERT_NE(file, INVALID_HANDLE_VALUE);
+    DWORD count{};
+    EXPECT_TRUE(WriteFile(file, data.data(), DWORD(data.size()), &count, nullptr));
+    EXPECT_EQ(count, data.size());
+    EXPECT_FALSE(ReadFile(file, &data[0], 1, &count, nullptr));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_ACCESS_DENIED));
+    EXPECT_TRUE(CloseHandle(file));
+
+    EXPECT_EQ(CreateFileW(L"c:/data/file.bin", GENERIC_WRITE, 0, nullptr,
+                          CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr), INVALID_HANDLE_VALUE);
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_FILE_EXISTS));
+
+    file = CreateFileW(L"c:/data/file.bin", GENERIC_READ, 0, nullptr,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    ASSERT_NE(file, INVALID_HANDLE_VALUE);
+    std::string read(data.size() + 10, '\0');
+    EXPECT_TRUE(ReadFile(file, &read[0], DWORD(read.size()), &count, nullptr));
+    EXPECT_EQ(count, data.size());
+    read.resize(count);
+    EXPECT_EQ(read, data);
+    EXPECT_TRUE(ReadFile(file, &read[0], 1, &count, nullptr));
+    EXPECT_EQ(count, 0u);
+    EXPECT_TRUE(CloseHandle(file));
+    EXPECT_FALSE(CloseHandle(file));
+
+    EXPECT_EQ(fs.Load(L"C:\\DATA\\FILE.BIN"), data);
+}
+
+TEST(MemFsTestSuite, Test_Fault_Snapshot)
+{
+    ffmock::memfs::FileSystem fs;
+    Mocks::FileSystemMount mount(fs);
+    fs.Store(L"C:\\app.ini", "[app]", 5);
+    ffmock::memfs::FileSystem::Snapshot saved{fs.Save()};
+
+    // Fail the second read
+    fs.Fault(L"C:\\app.ini", ffmock::memfs::Operation::Read, ERROR_CRC, 1, 1);
+    HANDLE file{CreateFileW(L"C:\\app.ini", GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    ASSERT_NE(file, INVALID_HANDLE_VALUE);
+    char buffer[8]{};
+    DWORD count{};
+    EXPECT_TRUE(ReadFile(file, buffer, 1, &count, nullptr));
+    EXPECT_FALSE(ReadFile(file, buffer, 1, &count, nullptr));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_CRC));
+    EXPECT_TRUE(ReadFile(file, buffer, 1, &count, nullptr));
+    EXPECT_TRUE(WriteFile(file, "XXXX", 4, &count, nullptr));
+    EXPECT_TRUE(CloseHandle(file));
+    EXPECT_EQ(fs.Load(L"C:\\app.ini"), "[aXXXX");
+
+    fs.Restore(saved);
+    EXPECT_EQ(fs.Load(L"C:\\app.ini"), "[app]");
+}
+
+/******************************************************
+ * @brief Simulated asynchronous I/O unit tests
+ ******************************************************/
+static std::vector<size_t> CompletionOrder(ffmock::async::Policy const& Rules)
+{
+    ffmock::memfs::FileSystem fs;
+    ffmock::async::Engine io(Rules);
+    Mocks::AsyncMount mount(fs, io);
+    fs.Store(L"C:\\data.bin", std::string(8 * ffmock::memfs::Page_k, 'd'));
+
+    HANDLE file{CreateFileW(L"C:\\data.bin", GENERIC_READ, 0, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_OVERLAPPED, nullptr)};
+    HANDLE port{CreateIoCompletionPort(file, nullptr, 7, 0)};
+    EXPECT_NE(port, nullptr);
+    static char buffers[8][ffmock::memfs::Page_k];
+    OVERLAPPED overlapped[8]{};
+    for (size_t index = 0; index < 8; ++index)
+    {
+        overlapped[index].Offset = DWORD(index * ffmock::memfs::Page_k);
+        EXPECT_FALSE(ReadFile(file, buffers[index], sizeof(buffers[index]), nullptr, &overlapped[index]));
+        EXPECT_EQ(GetLastError(), DWORD(ERROR_IO_PENDING));
+    }
+
+    std::vector<size_t> order;
+    DWORD bytes;
+    ULONG_PTR key;
+    LPOVERLAPPED completed;
+    while (GetQueuedCompletionStatus(port, &bytes, &key, &completed, 1000))
+    {
+        EXPECT_EQ(key, 7u);
+        EXPECT_GT(bytes, 0u);
+        EXPECT_LE(bytes, DWORD(ffmock::memfs::Page_k));
+        order.push_back(size_t(completed - overlapped));
+    }
+    EXPECT_EQ(GetLastError(), DWORD(WAIT_TIMEOUT));
+    EXPECT_GE(io.Now(), Rules.MinDelay + 1000);
+    EXPECT_TRUE(CloseHandle(port));
+    EXPECT_TRUE(CloseHandle(file));
+    return order;
+}
+
+TEST(AsyncTestSuite, Test_Seeded_Order)
+{
+    ffmock::async::Policy rules;
+    rules.Seed = 42;
+    rules.MinDelay = 10;
+    rules.MaxDelay = 100;
+    rules.Reorder = true;
+    rules.Partial = 50;
+    std::vector<size_t> order{CompletionOrder(rules)};
+
+    // The same seed replays the same schedule
+    EXPECT_EQ(CompletionOrder(rules), order);
+    std::sort(order.begin(), order.end());
+    EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST(AsyncTestSuite, Test_Manual_Completion)
+{
+    ffmock::async::Policy rules;
+    rules.AutoAdvance = false;
+    ffmock::memfs::FileSystem fs;
+    ffmock::async::Engine io(rules);
+    Mocks::AsyncMount mount(fs, io);
+    fs.Store(L"C:\\data.bin", "0123456789", 10);
+
+    HANDLE file{CreateFileW(L"C:\\data.bin", GENERIC_READ, 0, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_OVERLAPPED, nullptr)};
+    ASSERT_NE(file, INVALID_HANDLE_VALUE);
+    char buffer[10]{};
+    OVERLAPPED overlapped{};
+    overlapped.Offset = 2;
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    EXPECT_FALSE(ReadFile(file, buffer, sizeof(buffer), nullptr, &overlapped));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_IO_PENDING));
+    DWORD bytes{};
+    EXPECT_FALSE(GetOverlappedResult(file, &overlapped, &bytes, FALSE));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_IO_INCOMPLETE));
+    EXPECT_EQ(WaitForSingleObject(overlapped.hEvent, 0), DWORD(WAIT_TIMEOUT));
+
+    // Partial transfer
+    EXPECT_TRUE(io.Complete(&overlapped, 3));
+    EXPECT_EQ(WaitForSingleObject(overlapped.hEvent, 0), WAIT_OBJECT_0);
+    EXPECT_TRUE(GetOverlappedResult(file, &overlapped, &bytes, FALSE));
+    EXPECT_EQ(bytes, 3u);
+    EXPECT_EQ(std::string(buffer, 3), "234");
+
+    EXPECT_FALSE(ReadFile(file, buffer, sizeof(buffer), nullptr, &overlapped));
+    EXPECT_EQ(io.Pending(), 1u);
+    EXPECT_TRUE(CancelIoEx(file, &overlapped));
+    EXPECT_FALSE(GetOverlappedResult(file, &overlapped, &bytes, TRUE));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_OPERATION_ABORTED));
+    EXPECT_FALSE(CancelIoEx(file, &overlapped));
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_NOT_FOUND));
+
+    EXPECT_TRUE(CloseHandle(file));
+    CloseHandle(overlapped.hEvent);
+}
+
+TEST(AsyncTestSuite, Test_Dequeue_Deadline)
+{
+    ffmock::async::Policy rules;
+    rules.MinDelay = 5000;
+    ffmock::memfs::FileSystem fs;
+    ffmock::async::Engine io(rules);
+    Mocks::AsyncMount mount(fs, io);
+    fs.Store(L"C:\\data.bin", "0123456789", 10);
+
+    HANDLE file{CreateFileW(L"C:\\data.bin", GENERIC_READ, 0, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_OVERLAPPED, nullptr)};
+    HANDLE port{CreateIoCompletionPort(file, nullptr, 1, 0)};
+    ASSERT_NE(port, nullptr);
+    char buffer[10]{};
+    OVERLAPPED overlapped{};
+    EXPECT_FALSE(ReadFile(file, buffer, sizeof(buffer), nullptr, &overlapped));
+
+    // A short wait times out without completing operations due later
+    const ULONGLONG start{io.Now()};
+    DWORD bytes;
+    ULONG_PTR key;
+    LPOVERLAPPED completed;
+    EXPECT_FALSE(GetQueuedCompletionStatus(port, &bytes, &key, &completed, 100));
+    EXPECT_EQ(GetLastError(), DWORD(WAIT_TIMEOUT));
+    EXPECT_EQ(io.Now(), start + 100);
+    EXPECT_EQ(io.Pending(), 1u);
+
+    // Posted packets succeed even when their OVERLAPPED carries a status
+    OVERLAPPED posted{};
+    posted.Internal = ERROR_HANDLE_EOF;
+    EXPECT_TRUE(PostQueuedCompletionStatus(port, 3, 2, &posted));
+    EXPECT_TRUE(GetQueuedCompletionStatus(port, &bytes, &key, &completed, 0));
+    EXPECT_EQ(bytes, 3u);
+    EXPECT_EQ(key, 2u);
+    EXPECT_EQ(completed, &posted);
+
+    EXPECT_TRUE(GetQueuedCompletionStatus(port, &bytes, &key, &completed, INFINITE));
+    EXPECT_EQ(completed, &overlapped);
+    EXPECT_EQ(bytes, 10u);
+    EXPECT_TRUE(CloseHandle(port));
+    EXPECT_TRUE(CloseHandle(file));
+}
+
+/******************************************************
+ * @brief In-memory socket unit tests
+ ******************************************************/
+static void ConnectPair(USHORT Port, SOCKET& Client, SOCKET& Server)
+{
+    SOCKET listener{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+    ASSERT_NE(listener, INVALID_SOCKET);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(Port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    EXPECT_EQ(listen(listener, SOMAXCONN), 0);
+
+    Client = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT_EQ(connect(Client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    Server = accept(listener, nullptr, nullptr);
+    EXPECT_NE(Server, INVALID_SOCKET);
+    EXPECT_EQ(closesocket(listener), 0);
+}
+
+TEST(SocketTestSuite, Test_Backpressure)
+{
+    ffmock::sockets::Link link;
+    link.Capacity = 4096;
+    ffmock::sockets::Network net(link);
+    Mocks::NetworkMount mount(net);
+    SOCKET client, server;
+    ConnectPair(8080, client, server);
+
+    u_long nonblocking{1};
+    EXPECT_EQ(ioctlsocket(client, FIONBIO, &nonblocking), 0);
+    static char data[8192];
+    std::fill(std::begin(data), std::end(data), 'x');
+    EXPECT_EQ(send(client, data, sizeof(data), 0), 4096);
+    EXPECT_EQ(send(client, data, sizeof(data), 0), SOCKET_ERROR);
+    EXPECT_EQ(WSAGetLastError(), WSAEWOULDBLOCK);
+
+    // Receiving frees space for the sender
+    static char buffer[8192];
+    EXPECT_EQ(recv(server, buffer, 1024, 0), 1024);
+    EXPECT_EQ(send(client, data, sizeof(data), 0), 1024);
+
+    u_long available{};
+    EXPECT_EQ(ioctlsocket(server, FIONREAD, &available), 0);
+    EXPECT_EQ(available, 4096u);
+    EXPECT_EQ(closesocket(client), 0);
+    EXPECT_EQ(recv(server, buffer, sizeof(buffer), 0), 4096);
+    EXPECT_EQ(recv(server, buffer, sizeof(buffer), 0), 0);
+    EXPECT_EQ(closesocket(server), 0);
+}
+
+TEST(SocketTestSuite, Test_Poll_Infinite)
+{
+    ffmock::sockets::Network net;
+    Mocks::NetworkMount mount(net);
+    SOCKET listener{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(8080);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    EXPECT_EQ(listen(listener, SOMAXCONN), 0);
+
+    // Nothing is in flight, so the poll waits for the connecting thread
+    SOCKET client{socket(AF_INET, SOCK_STREAM, 0)};
+    std::thread connector([&]
+        {
+            Sleep(50);
+            EXPECT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+        });
+    WSAPOLLFD polled{listener, POLLRDNORM, 0};
+    EXPECT_EQ(WSAPoll(&polled, 1, -1), 1);
+    EXPECT_EQ(polled.revents, POLLRDNORM);
+    EXPECT_EQ(net.Now(), 0u);
+    connector.join();
+
+    SOCKET server{accept(listener, nullptr, nullptr)};
+    EXPECT_NE(server, INVALID_SOCKET);
+    for (SOCKET handle : {listener, client, server})
+    {
+        EXPECT_EQ(closesocket(handle), 0);
+    }
+}
+
+TEST(SocketTestSuite, Test_Bandwidth_Latency)
+{
+    ffmock::sockets::Link link;
+    link.Bandwidth = 1000000;
+    link.Latency = 10000;
+    ffmock::sockets::Network net(link);
+    Mocks::NetworkMount mount(net);
+    SOCKET client, server;
+    ConnectPair(8080, client, server);
+
+    static char data[1000];
+    EXPECT_EQ(send(client, data, sizeof(data), 0), 1000);
+    u_long nonblocking{1};
+    EXPECT_EQ(ioctlsocket(server, FIONBIO, &nonblocking), 0);
+    EXPECT_EQ(recv(server, data, sizeof(data), 0), SOCKET_ERROR);
+    EXPECT_EQ(WSAGetLastError(), WSAEWOULDBLOCK);
+    WSAPOLLFD polled{server, POLLRDNORM, 0};
+    EXPECT_EQ(WSAPoll(&polled, 1, 0), 0);
+
+    // 1ms to transmit, 10ms on the wire
+    EXPECT_EQ(WSAPoll(&polled, 1, 100), 1);
+    EXPECT_EQ(polled.revents, POLLRDNORM);
+    EXPECT_EQ(net.Now(), 11000u);
+    EXPECT_EQ(recv(server, data, sizeof(data), 0), 1000);
+
+    // Simulated and real sockets can't be polled together
+    WSAPOLLFD mixed[2]{{server, POLLRDNORM, 0}, {SOCKET(0x1234), POLLRDNORM, 0}};
+    EXPECT_EQ(WSAPoll(mixed, 2, 0), SOCKET_ERROR);
+    EXPECT_EQ(WSAGetLastError(), WSAEINVAL);
+
+    // Every send to a lossy port is retransmitted
+    link.Loss = 100;
+    net.Shape(9090, link);
+    SOCKET lossy, peer;
+    ConnectPair(9090, lossy, peer);
+    EXPECT_EQ(send(lossy, data, sizeof(data), 0), 1000);
+    EXPECT_EQ(recv(peer, data, sizeof(data), 0), 1000);
+    EXPECT_EQ(net.Now(), 22000u + link.Retransmit);
+
+    for (SOCKET handle : {client, server, lossy, peer})
+    {
+        EXPECT_EQ(closesocket(handle), 0);
+    }
+}
+
+/******************************************************
+ * @brief Thread pool redirection unit tests
+ ******************************************************/
+static DWORD WINAPI Record(LPVOID Parameter)
+{
+    static std::vector<DWORD_PTR> order;
+    if (!Parameter)
+    {
+        order.clear();
+        return 0;
+    }
+    order.push_back(DWORD_PTR(Parameter));
+    return DWORD(order.size());
+}
+
+TEST(ThreadPoolTestSuite, Test_Join_Reuse)
+{
+    ffmock::threads::Pool pool(2);
+    Mocks::ThreadPoolMount mount(pool);
+    std::atomic<ULONG> calls{};
+    auto routine = [](LPVOID Parameter) -> DWORD
+        {
+            static_cast<std::atomic<ULONG>*>(Parameter)->fetch_add(1);
+            return 7;
+        };
+    for (int index = 0; index < 1000; ++index)
+    {
+        DWORD id{};
+        HANDLE thread{CreateThread(nullptr, 0, routine, &calls, 0, &id)};
+        ASSERT_NE(thread, nullptr);
+        EXPECT_GE(id, ffmock::threads::FirstId_k);
+        EXPECT_EQ(WaitForSingleObject(thread, INFINITE), WAIT_OBJECT_0);
+        DWORD code{};
+        EXPECT_TRUE(GetExitCodeThread(thread, &code));
+        EXPECT_EQ(code, 7u);
+        EXPECT_TRUE(CloseHandle(thread));
+        EXPECT_FALSE(pool.Owns(thread));
+    }
+    EXPECT_EQ(calls.load(), 1000u);
+    EXPECT_EQ(pool.Spawned(), 2u);
+
+    // Routines waiting for each other get a worker of their own
+    HANDLE threads[8];
+    std::atomic<ULONG> arrived{};
+    auto barrier = [](LPVOID Parameter) -> DWORD
+        {
+            auto& count = *static_cast<std::atomic<ULONG>*>(Parameter);
+            count.fetch_add(1);
+            while (count.load() < 8)
+            {
+                SwitchToThread();
+            }
+            return 0;
+        };
+    for (HANDLE& thread : threads)
+    {
+        thread = CreateThread(nullptr, 0, barrier, &arrived, 0, nullptr);
+    }
+    EXPECT_EQ(WaitForMultipleObjects(8, threads, TRUE, INFINITE), WAIT_OBJECT_0);
+    EXPECT_EQ(pool.Spawned(), 8u);
+    for (HANDLE thread : threads)
+    {
+        CloseHandle(thread);
+    }
+}
+
+TEST(ThreadPoolTestSuite, Test_Serialized_Order)
+{
+    ffmock::threads::Pool pool(0, true);
+    Mocks::ThreadPoolMount mount(pool);
+    Record(nullptr);
+    HANDLE suspended{CreateThread(nullptr, 0, Record, LPVOID(100), CREATE_SUSPENDED, nullptr)};
+    HANDLE threads[16];
+    for (DWORD_PTR index = 0; index < 16; ++index)
+    {
+        threads[index] = CreateThread(nullptr, 0, Record, LPVOID(index + 1), 0, nullptr);
+    }
+    EXPECT_EQ(WaitForMultipleObjects(16, threads, TRUE, INFINITE), WAIT_OBJECT_0);
+    DWORD code{};
+    EXPECT_TRUE(GetExitCodeThread(suspended, &code));
+    EXPECT_EQ(code, DWORD(STILL_ACTIVE));
+
+    EXPECT_EQ(ResumeThread(suspended), 1u);
+    EXPECT_EQ(ResumeThread(suspended), 0u);
+    EXPECT_EQ(WaitForSingleObject(suspended, INFINITE), WAIT_OBJECT_0);
+    EXPECT_TRUE(GetExitCodeThread(suspended, &code));
+    EXPECT_EQ(code, 17u);
+    for (DWORD index = 0; index < 16; ++index)
+    {
+        EXPECT_TRUE(GetExitCodeThread(threads[index], &code));
+        EXPECT_EQ(code, index + 1);
+        CloseHandle(threads[index]);
+    }
+    CloseHandle(suspended);
+    EXPECT_EQ(pool.Spawned(), 1u);
+
+    // A closed thread's handle value reused by another object isn't the pool's
+    HANDLE thread{CreateThread(nullptr, 0, Record, LPVOID(200), CREATE_SUSPENDED, nullptr)};
+    EXPECT_TRUE(CloseHandle(thread));
+    HANDLE event{CreateEventW(nullptr, TRUE, FALSE, nullptr)};
+    EXPECT_FALSE(pool.Owns(event));
+    EXPECT_EQ(GetExitCodeThread(event, &code), FALSE);
+    CloseHandle(event);
+}
+
+/******************************************************
+ * @brief Lock contention profiler unit tests
+ ******************************************************/
+static ffmock::contention::LockReport const* FindLock(std::vector<ffmock::contention::LockReport> const& Report,
+                                                      const char* Name)
+{
+    for (auto const& lock : Report)
+    {
+        if (lock.Name && !strcmp(lock.Name, Name))
+        {
+            return &lock;
+        }
+    }
+    return nullptr;
+}
+
+TEST(ContentionTestSuite, Test_Hot_Lock)
+{
+    static SRWLOCK hot = SRWLOCK_INIT;
+    static SRWLOCK cold = SRWLOCK_INIT;
+    ffmock::contention::Profiler profiler;
+    Mocks::ContentionMount mount(profiler);
+    profiler.Name(&hot, "hot");
+    profiler.Name(&cold, "cold");
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread)
+    {
+        threads.emplace_back([]
+            {
+                for (int index = 0; index < 200; ++index)
+                {
+                    AcquireSRWLockExclusive(&hot);
+                    Sleep(index % 50 ? 0 : 1);
+                    ReleaseSRWLockExclusive(&hot);
+                    AcquireSRWLockShared(&cold);
+                    ReleaseSRWLockShared(&cold);
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto report = profiler.Report();
+    ASSERT_FALSE(report.empty());
+    EXPECT_STREQ(report[0].Name, "hot");
+    EXPECT_EQ(report[0].Kind, ffmock::contention::Primitive::Exclusive);
+    EXPECT_EQ(report[0].Acquired, 800u);
+    EXPECT_GT(report[0].Contended, 0u);
+    EXPECT_GT(report[0].P99WaitNs, 0.0);
+    EXPECT_LE(report[0].P99WaitNs, report[0].MaxWaitNs);
+    EXPECT_GT(report[0].HoldNs, 0.0);
+    EXPECT_FALSE(report[0].Sites.empty());
+
+    auto cold_lock = FindLock(report, "cold");
+    ASSERT_NE(cold_lock, nullptr);
+    EXPECT_EQ(cold_lock->Kind, ffmock::contention::Primitive::Shared);
+    EXPECT_EQ(cold_lock->Acquired, 800u);
+    EXPECT_EQ(cold_lock->Contended, 0u);
+    EXPECT_EQ(profiler.Dropped(), 0u);
+}
+
+TEST(ContentionTestSuite, Test_Wait_Site)
+{
+    ffmock::contention::Profiler profiler;
+    Mocks::ContentionMount mount(profiler);
+    HANDLE event{CreateEventW(nullptr, TRUE, FALSE, nullptr)};
+    profiler.Name(event, "event");
+
+    EXPECT_EQ(WaitForSingleObject(event, 0), DWORD(WAIT_TIMEOUT));
+    std::thread setter([event]
+        {
+            Sleep(20);
+            SetEvent(event);
+        });
+    EXPECT_EQ(WaitForSingleObject(event, INFINITE), WAIT_OBJECT_0);
+    setter.join();
+    EXPECT_EQ(WaitForSingleObject(event, 0), WAIT_OBJECT_0);
+    CloseHandle(event);
+
+    auto report = profiler.Report();
+    auto waited = FindLock(report, "event");
+    ASSERT_NE(waited, nullptr);
+    EXPECT_EQ(waited->Kind, ffmock::contention::Primitive::Wait);
+    EXPECT_EQ(waited->Acquired, 2u);
+    EXPECT_EQ(waited->Contended, 1u);
+    EXPECT_GE(waited->WaitNs, 10e6);
+    EXPECT_DOUBLE_EQ(waited->MaxWaitNs, waited->WaitNs);
+
+    // The call site is in this test
+    ASSERT_EQ(waited->Sites.size(), 1u);
+    HMODULE module{};
+    EXPECT_TRUE(GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                   static_cast<LPCWSTR>(waited->Sites[0].Address), &module));
+    EXPECT_EQ(module, GetModuleHandleW(nullptr));
+    EXPECT_EQ(waited->Sites[0].Contended, 1u);
+}
+
+/******************************************************
+ * @brief Fuzzer-driven mock unit tests
+ ******************************************************/
+TEST(FuzzTestSuite, Test_Decide_Outcomes)
+{
+    using Outcome = ffmock::fuzz::Outcome<Mocks::FFRegOpenKeyW>;
+    static constexpr std::array<Outcome, 3> outcomes{{
+        {ERROR_SUCCESS, NO_ERROR, [](ffmock::fuzz::Input& Source, HKEY, LPCWSTR, PHKEY Result)
+            {
+                *Result = reinterpret_cast<HKEY>(ULONG_PTR(Source.Take<USHORT>()));
+            }},
+        Outcome::Failure(),
+        {ERROR_ACCESS_DENIED, ERROR_ACCESS_DENIED}}};
+
+    ffmock::fuzz::Input input;
+    ffmock::fuzz::Decider decider(input, outcomes);
+    Mocks::FFRegOpenKeyW::Guard guard(std::ref(decider));
+
+    // Outcome indexes wrap around, the success writes the next 2 bytes as the key
+    static const BYTE data[]{2, 4, 0, 0x34, 0x12, 1};
+    input.Reset(data, sizeof(data));
+    HKEY key{};
+    SetLastError(NO_ERROR);
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_ACCESS_DENIED);
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_ACCESS_DENIED));
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), Mocks::FFRegOpenKeyW::Error_k);
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+    EXPECT_EQ(key, reinterpret_cast<HKEY>(ULONG_PTR(0x1234)));
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), Mocks::FFRegOpenKeyW::Error_k);
+    EXPECT_EQ(input.Remaining(), 0u);
+
+    // An exhausted input takes the first outcome, with zeros for the out parameters
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+    EXPECT_EQ(key, nullptr);
+}
+
+TEST(FuzzTestSuite, Test_Iterations_No_Allocation)
+{
+    using CreateOutcome = ffmock::fuzz::Outcome<Mocks::FFRegCreateKeyExW>;
+    using SetOutcome = ffmock::fuzz::Outcome<Mocks::FFRegSetValueExW>;
+    using CloseOutcome = ffmock::fuzz::Outcome<Mocks::FFRegCloseKey>;
+    static constexpr std::array<CreateOutcome, 2> creates{{
+        {ERROR_SUCCESS, NO_ERROR, [](ffmock::fuzz::Input&, HKEY, LPCWSTR, DWORD, LPWSTR, DWORD, REGSAM,
+                                     LPSECURITY_ATTRIBUTES, PHKEY Result, LPDWORD)
+            {
+                *Result = reinterpret_cast<HKEY>(ULONG_PTR(0x1234));
+            }},
+        CreateOutcome::Failure()}};
+    static constexpr std::array<SetOutcome, 2> sets{{{ERROR_SUCCESS}, {ERROR_ACCESS_DENIED}}};
+    static constexpr std::array<CloseOutcome, 1> closes{{{ERROR_SUCCESS}}};
+
+    ffmock::fuzz::Input input;
+    ffmock::fuzz::Decider create(input, creates);
+    ffmock::fuzz::Decider set(input, sets);
+    ffmock::fuzz::Decider close(input, closes);
+    Mocks::FFRegCreateKeyExW::Guard createGuard(std::ref(create));
+    Mocks::FFRegSetValueExW::Guard setGuard(std::ref(set));
+    Mocks::FFRegCloseKey::Guard closeGuard(std::ref(close));
+
+    auto iteration = [&input](const BYTE* Data, size_t Size)
+        {
+            input.Reset(Data, Size);
+            Registry registry;
+            return registry.Create(L"Software\\_DeleteMe_") &&
+                   registry.AddStringValue(L"Fuzzed", L"Value", REG_SZ);
+        };
+    static const BYTE failedCreate[]{1};
+    static const BYTE failedSet[]{0, 1};
+    EXPECT_FALSE(iteration(failedCreate, sizeof(failedCreate)));
+    EXPECT_FALSE(iteration(failedSet, sizeof(failedSet)));
+    EXPECT_TRUE(iteration(nullptr, 0));
+
+    // Resetting the input between iterations allocates nothing (counted by the debug heap only)
+    int succeeded{};
+#ifdef _DEBUG
+    _CrtMemState before{};
+    _CrtMemCheckpoint(&before);
+#endif
+    for (int index = 0; index < 1000; ++index)
+    {
+        succeeded += iteration(nullptr, 0) ? 1 : 0;
+    }
+#ifdef _DEBUG
+    _CrtMemState after{};
+    _CrtMemCheckpoint(&after);
+    EXPECT_EQ(after.lTotalCount, before.lTotalCount);
+#endif
+    EXPECT_EQ(succeeded, 1000);
+}
+
+/******************************************************
+ * @brief Expectations unit tests
+ ******************************************************/
+TEST(ExpectTestSuite, Test_Matchers_Cardinality)
+{
+    using namespace ffmock::expect;
+
+    // Matchers are composed and evaluated at compile time
+    static_assert(Call(Gt(1u), Not(0u), _).Matches(2u, 3u, nullptr));
+    static_assert(!Call(AllOf(Ge(1), Le(3)), StrEq("a")).Matches(4, "a"));
+    static_assert(Call(AnyOf(1, 5), StrEq(L"b")).Matches(5, L"b"));
+
+    auto expected = Expect<Mocks::FFRegOpenKeyW>(
+        Call(HKEY_LOCAL_MACHINE, StrEq(L"Software\\Microsoft"), NotNull())
+            .Times(2)
+            .Invoke([](HKEY, LPCWSTR, PHKEY Result) -> LSTATUS
+                {
+                    *Result = nullptr;
+                    return ERROR_SUCCESS;
+                }),
+        Call(AnyOf(HKEY_LOCAL_MACHINE, HKEY_CURRENT_USER), _, _)
+            .AtMost(1)
+            .Return(ERROR_ACCESS_DENIED, ERROR_ACCESS_DENIED));
+    Mocks::FFRegOpenKeyW::Guard guard(std::ref(expected));
+
+    HKEY key{HKEY_LOCAL_MACHINE};
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+    EXPECT_EQ(key, nullptr);
+    SetLastError(NO_ERROR);
+    EXPECT_EQ(RegOpenKeyW(HKEY_CURRENT_USER, L"Software\\Microsoft", &key), ERROR_ACCESS_DENIED);
+    EXPECT_EQ(GetLastError(), DWORD(ERROR_ACCESS_DENIED));
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+
+    // Both expectations are saturated
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), Mocks::FFRegOpenKeyW::Error_k);
+    EXPECT_EQ(expected.Calls(0), 2u);
+    EXPECT_EQ(expected.Calls(1), 1u);
+    EXPECT_TRUE(expected.Satisfied(0));
+    EXPECT_TRUE(expected.Satisfied(1));
+    EXPECT_EQ(expected.Unexpected(), 1u);
+    EXPECT_FALSE(expected.Verify());
+}
+
+TEST(ExpectTestSuite, Test_Sequence_No_Allocation)
+{
+    using namespace ffmock::expect;
+    const HKEY fake{reinterpret_cast<HKEY>(ULONG_PTR(0x1234))};
+
+    Sequence order;
+    auto opens = Expect<Mocks::FFRegOpenKeyW>(
+        Call(HKEY_LOCAL_MACHINE, _, NotNull())
+            .InSequence(order)
+            .Invoke([](HKEY, LPCWSTR, PHKEY Result) -> LSTATUS
+                {
+                    *Result = reinterpret_cast<HKEY>(ULONG_PTR(0x1234));
+                    return ERROR_SUCCESS;
+                }));
+    auto deletes = Expect<Mocks::FFRegDeleteValueW>(
+        Call(fake, StrEq(L"_DeleteMe_")).Times(1000).InSequence(order).Return(ERROR_SUCCESS));
+    auto closes = Expect<Mocks::FFRegCloseKey>(
+        Call(fake).InSequence(order).Return(ERROR_SUCCESS));
+    Mocks::FFRegOpenKeyW::Guard openGuard(std::ref(opens));
+    Mocks::FFRegDeleteValueW::Guard deleteGuard(std::ref(deletes));
+    Mocks::FFRegCloseKey::Guard closeGuard(std::ref(closes));
+
+    // Closing the key before it was opened is out of order
+    EXPECT_EQ(RegCloseKey(fake), Mocks::FFRegCloseKey::Error_k);
+    HKEY key{};
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_SUCCESS);
+    EXPECT_EQ(key, fake);
+
+    // Matching a thousand calls allocates nothing (counted by the debug heap only)
+    int succeeded{};
+#ifdef _DEBUG
+    _CrtMemState before{};
+    _CrtMemCheckpoint(&before);
+#endif
+    for (int index = 0; index < 1000; ++index)
+    {
+        succeeded += RegDeleteValueW(key, L"_DeleteMe_") == ERROR_SUCCESS ? 1 : 0;
+    }
+#ifdef _DEBUG
+    _CrtMemState after{};
+    _CrtMemCheckpoint(&after);
+    EXPECT_EQ(after.lTotalCount, before.lTotalCount);
+#endif
+    EXPECT_EQ(succeeded, 1000);
+
+    EXPECT_EQ(RegCloseKey(key), ERROR_SUCCESS);
+    // The open expectation is saturated
+    EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), Mocks::FFRegOpenKeyW::Error_k);
+
+    EXPECT_TRUE(deletes.Verify());
+    EXPECT_EQ(opens.Unexpected(), 1u);
+    EXPECT_FALSE(opens.Verify());
+    EXPECT_TRUE(closes.Satisfied(0));
+    EXPECT_EQ(closes.Unexpected(), 1u);
+}
+
+/******************************************************
+ * @brief Hot reload unit tests
+ *
+ * @details The tests swap two builds of Reloadable.cpp,
+ *          next to the test executable.
+ ******************************************************/
+static std::wstring TestModule(PCWSTR Name)
+{
+    WCHAR path[MAX_PATH]{};
+    GetModuleFileNameW(nullptr, path, ARRAYSIZE(path));
+    std::wstring module{path};
+    return module.substr(0, module.find_last_of(L'\\') + 1) + Name;
+}
+
+TEST(HotReloadTestSuite, Test_Reload_Behavior)
+{
+    const std::wstring path{TestModule(L"Reloadable.dll")};
+    if (!CopyFileW(TestModule(L"Reloadable_v1.dll").c_str(), path.c_str(), FALSE))
+    {
+        GTEST_SKIP() << "Reloadable_v1.dll wasn't built";
+    }
+    {
+        ffmock::reload::Library library(path.c_str());
+        ASSERT_TRUE(library.Loaded());
+        ffmock::reload::Binding<Mocks::FFRegOpenKeyW> open(library, "Mock_RegOpenKeyW");
+        ffmock::reload::Binding<Mocks::FFRegCloseKey> close(library, "Mock_NoSuchExport");
+        EXPECT_TRUE(open.Bound());
+        EXPECT_FALSE(close.Bound());
+
+        HKEY key{HKEY_CURRENT_USER};
+        EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_ACCESS_DENIED);
+        EXPECT_EQ(key, nullptr);
+        EXPECT_FALSE(library.Changed());
+
+        // Rebuild, while the library is loaded
+        ASSERT_TRUE(CopyFileW(TestModule(L"Reloadable_v2.dll").c_str(), path.c_str(), FALSE));
+        EXPECT_TRUE(library.Changed());
+        EXPECT_TRUE(library.Reload());
+        EXPECT_EQ(library.Generation(), 2u);
+        EXPECT_FALSE(library.Changed());
+        EXPECT_EQ(RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key), ERROR_FILE_NOT_FOUND);
+
+        // Missing exports pass to the real API
+        EXPECT_EQ(RegCloseKey(nullptr), ERROR_INVALID_HANDLE);
+    }
+    EXPECT_TRUE(DeleteFileW(path.c_str()));
+}
+
+TEST(HotReloadTestSuite, Test_Drain_In_Flight)
+{
+    const std::wstring path{TestModule(L"Reloadable.dll")};
+    if (!CopyFileW(TestModule(L"Reloadable_v1.dll").c_str(), path.c_str(), FALSE))
+    {
+        GTEST_SKIP() << "Reloadable_v1.dll wasn't built";
+    }
+    HANDLE release{CreateEventW(nullptr, TRUE, FALSE, nullptr)};
+    ASSERT_NE(release, nullptr);
+    {
+        ffmock::reload::Library library(path.c_str());
+        ffmock::reload::Binding<Mocks::FFRegDeleteValueW> remove(library, "Mock_RegDeleteValueW");
+
+        // The call blocks in the library until the event is set
+        LSTATUS inFlight{ERROR_SUCCESS};
+        std::thread caller([&]
+            {
+                inFlight = RegDeleteValueW(reinterpret_cast<HKEY>(release), L"_DeleteMe_");
+            });
+        while (library.InFlight() != 1)
+        {
+            std::this_thread::yield();
+        }
+        EXPECT_FALSE(library.Reload(50));
+        EXPECT_EQ(GetLastError(), DWORD(ERROR_TIMEOUT));
+        EXPECT_EQ(library.Generation(), 1u);
+
+        // The reload waits for the call to return
+        ASSERT_TRUE(CopyFileW(TestModule(L"Reloadable_v2.dll").c_str(), path.c_str(), FALSE));
+        bool reloaded{};
+        std::thread reloader([&] { reloaded = library.Reload(); });
+        Sleep(20);
+        SetEvent(release);
+        caller.join();
+        reloader.join();
+
+        EXPECT_EQ(inFlight, ERROR_ACCESS_DENIED);
+        EXPECT_TRUE(reloaded);
+        EXPECT_EQ(library.Generation(), 2u);
+        EXPECT_EQ(library.InFlight(), 0);
+        EXPECT_EQ(RegDeleteValueW(reinterpret_cast<HKEY>(release), L"_DeleteMe_"), ERROR_FILE_NOT_FOUND);
+    }
+    CloseHandle(release);
+    EXPECT_TRUE(DeleteFileW(path.c_str()));
+}
+
+/******************************************************
+ * @brief Interleaving explorer unit tests
+ ******************************************************/
+static bool CountsAll(ffmock::interleave::Scheduler& Scheduler, bool Locked)
+{
+    CRITICAL_SECTION section;
+    InitializeCriticalSection(&section);
+    LONG counter{};
+    auto increment = [&]
+        {
+            for (int round = 0; round < 2; ++round)
+            {
+                if (Locked)
+                {
+                    EnterCriticalSection(&section);
+                }
+                const LONG value{counter};
+                RegCloseKey(nullptr);       // Scheduling point
+                counter = value + 1;
+                if (Locked)
+                {
+                    LeaveCriticalSection(&section);
+                }
+            }
+        };
+    const bool returned{Scheduler.Run({increment, increment})};
+    DeleteCriticalSection(&section);
+    return returned && counter == 4;
+}
+
+static bool CountsAllRandom(ULONGLONG Seed)
+{
+    ffmock::interleave::Random strategy(Seed);
+    ffmock::interleave::Scheduler scheduler(strategy);
+    return CountsAll(scheduler, false);
+}
+
+TEST(InterleaveTestSuite, Test_Lost_Update_Replay)
+{
+    using namespace ffmock::interleave;
+    Mocks::InterleaveMount mount;
+
+    Explorer explorer({1, 200});
+    Report report{explorer.Explore(&CountsAllRandom)};
+    ASSERT_TRUE(report.Failed);
+    EXPECT_EQ(report.Explored, *report.Failed - 1);
+
+    // The failing schedule replays exactly
+    std::vector<ULONG> traces[2];
+    for (auto& trace : traces)
+    {
+        Random strategy(*report.Failed);
+        Scheduler scheduler(strategy);
+        EXPECT_FALSE(CountsAll(scheduler, false));
+        EXPECT_GT(scheduler.Preemptions(), 0u);
+        trace = scheduler.Trace();
+    }
+    EXPECT_EQ(traces[0], traces[1]);
+
+    // No schedule loses an update under the lock
+    report = explorer.Explore([](ULONGLONG Seed)
+        {
+            Bounded strategy(Seed, 2, 20);
+            Scheduler scheduler(strategy);
+            return CountsAll(scheduler, true);
+        });
+    EXPECT_FALSE(report.Failed);
+    EXPECT_EQ(report.Explored, 200u);
+}
+
+TEST(InterleaveTestSuite, Test_Deadlock_Timeout)
+{
+    using namespace ffmock::interleave;
+    Mocks::InterleaveMount mount;
+
+    // Locks taken in opposite orders (the threads of deadlocked runs are parked)
+    auto inverted = [](ULONGLONG Seed)
+        {
+            Pct strategy(Seed, 2, 8);
+            Scheduler scheduler(strategy);
+            CRITICAL_SECTION sections[2];
+            InitializeCriticalSection(&sections[0]);
+            InitializeCriticalSection(&sections[1]);
+            auto lock = [&sections](int First)
+                {
+                    EnterCriticalSection(&sections[First]);
+                    EnterCriticalSection(&sections[1 - First]);
+                    LeaveCriticalSection(&sections[1 - First]);
+                    LeaveCriticalSection(&sections[First]);
+                };
+            const bool returned{scheduler.Run({[&] { lock(0); }, [&] { lock(1); }})};
+            EXPECT_EQ(scheduler.Deadlocked(), !returned);
+            DeleteCriticalSection(&sections[0]);
+            DeleteCriticalSection(&sections[1]);
+            return returned;
+        };
+    Report report{Explorer({1, 100}).Explore(inverted)};
+    ASSERT_TRUE(report.Failed);
+    EXPECT_FALSE(inverted(*report.Failed));
+
+    // A timed wait times out once no other thread can run
+    HANDLE event{CreateEventW(nullptr, TRUE, FALSE, nullptr)};
+    ASSERT_NE(event, nullptr);
+    DWORD waited{};
+    Random strategy(1);
+    Scheduler scheduler(strategy);
+    EXPECT_TRUE(scheduler.Run({[&] { waited = WaitForSingleObject(event, 60000); }}));
+    EXPECT_EQ(waited, DWORD(WAIT_TIMEOUT));
+
+    // A waiting thread lets the signaling thread run
+    EXPECT_TRUE(scheduler.Run({[&] { waited = WaitForSingleObject(event, INFINITE); },
+                               [&] { SetEvent(event); }}));
+    EXPECT_EQ(waited, WAIT_OBJECT_0);
+    CloseHandle(event);
+}
+
+TEST(InterleaveTestSuite, Test_Parallel_Explore)
+{
+    using namespace ffmock::interleave;
+    Mocks::InterleaveMount mount;
+
+    // The child processes run this test again, up to the first Explore()
+    std::wstring commandLine{GetCommandLineW()};
+    commandLine += L" --gtest_filter=InterleaveTestSuite.Test_Parallel_Explore";
+    Report parallel{Explorer({1, 400, 4, 10000, commandLine.c_str()}).Explore(&CountsAllRandom)};
+    Report serial{Explorer({1, 400}).Explore(&CountsAllRandom)};
+    ASSERT_TRUE(serial.Failed);
+    EXPECT_EQ(parallel.Failed, serial.Failed);
+    EXPECT_GE(parallel.Explored, serial.Explored);
+}
+
+TEST(InterleaveTestSuite, Test_Parallel_Explore_Calls)
+{
+    using namespace ffmock::interleave;
+    Mocks::InterleaveMount mount;
+
+    // The child processes of each call explore that call's trial, skipping the other calls
+    std::wstring commandLine{GetCommandLineW()};
+    commandLine += L" --gtest_filter=InterleaveTestSuite.Test_Parallel_Explore_Calls";
+    Explorer explorer({1, 200, 2, 10000, commandLine.c_str()});
+    Report locked{explorer.Explore([](ULONGLONG Seed)
+        {
+            Random strategy(Seed);
+            Scheduler scheduler(strategy);
+            return CountsAll(scheduler, true);
+        })};
+    // The children of the next call get an empty report
+    if (!Explorer::Hosted())
+    {
+        EXPECT_FALSE(locked.Failed);
+        EXPECT_EQ(locked.Explored, 200u);
+    }
+
+    Report unlocked{explorer.Explore(&CountsAllRandom)};
+    Report serial{Explorer({1, 200}).Explore(&CountsAllRandom)};
+    EXPECT_TRUE(unlocked.Failed);
+    EXPECT_EQ(unlocked.Failed, serial.Failed);
+}
+
+/******************************************************
+ * @brief Cross-process mock control unit tests
+ *
+ * @details The test process spawns itself as the child
+ *          process, then changes the child's mocks.
+ ******************************************************/
+class ControlTestSuite : public testing::Test
+{
+protected:
+    void SetUp(void) override
+    {
+        ASSERT_TRUE(Controller);
+        Child.reset(Controller.Spawn(GetCommandLineW()));
+        ASSERT_TRUE(Child);
+    }
+
+    void TearDown(void) override
+    {
+        if (Child && WaitForSingleObject(Child.get(), 0) == WAIT_TIMEOUT)
+        {
+            TerminateProcess(Child.get(), ERROR_TIMEOUT);
+        }
+    }
+
+    DWORD ChildExitCode(void)
+    {
+        DWORD exitCode{ERROR_TIMEOUT};
+        if (WaitForSingleObject(Child.get(), ffmock::control::Timeout_k) == WAIT_OBJECT_0)
+        {
+            GetExitCodeProcess(Child.get(), &exitCode);
+        }
+        return exitCode;
+    }
+
+    ffmock::control::Controller Controller;
+    HANDLE_t Child{nullptr, &CloseHandle};
+};
+
+TEST_F(ControlTestSuite, Test_Return)
+{
+    using ffmock::control::Status;
+
+    ASSERT_EQ(Controller.Clear("NoSuchApi"), Status::NotFound);
+    ASSERT_GE(Controller.Calls("RegOpenKeyW"), 0);
+    ASSERT_EQ(Controller.Return("RegOpenKeyW", ERROR_ACCESS_DENIED), Status::Success);
+    ASSERT_EQ(ChildExitCode(), static_cast<DWORD>(ERROR_ACCESS_DENIED));
+}
+
+TEST_F(ControlTestSuite, Test_Fault)
+{
+    using ffmock::control::Status;
+
+    ASSERT_EQ(Controller.Fault("RegOpenKeyW", 0, 0, 0), Status::Invalid);
+    ASSERT_EQ(Controller.Fault("RegOpenKeyW", 3, 1), Status::Success);
+    ASSERT_EQ(ChildExitCode(), static_cast<DWORD>(ERROR_REGISTRY_IO_FAILED));
+}
+
+/**
+ * @brief Child process of the cross-process control tests
+ *
+ * @details Open a registry key until the test process makes the mocked API fail.
+ *
+ * @return int - The failure status
+ */
+static int ControlChild(void)
+{
+    for (;;)
+    {
+        HKEY key{};
+        LSTATUS status{RegOpenKeyW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft", &key)};
+        if (status)
+        {
+            return status;
+        }
+        RegCloseKey(key);
+    }
+}
+
+/**
+ * @brief Restore the real APIs after each test
+ */
+class MockRegistryListener : public ::testing::EmptyTestEventListener
+{
+    void OnTestEnd(::testing::TestInfo const&) override
+    {
+        ffmock::MockRegistry::ResetAll();
+    }
+};
+
 /**
  * @brief Uni tests entrypoint
  *
@@ -78,6 +1387,12 @@ TEST_F(RegistryTestSuite, Test_Create)
  */
 int wmain(_In_ int argc, _In_ wchar_t* argv[])
 {
+    if (ffmock::control::Server::Hosted())
+    {
+        return ControlChild();
+    }
+
     ::testing::InitGoogleTest(&argc, argv);
+    ::testing::UnitTest::GetInstance()->listeners().Append(new MockRegistryListener);
     return RUN_ALL_TESTS();
 }
\ No newline at end of file
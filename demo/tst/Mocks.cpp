@@ -23,10 +23,13 @@
 */
 
 #include "Mocks.hpp"
+#include <ffmock/control.h>
 
 #pragma warning(disable:4273) // inconsistent dll linkage
 
 static HMODULE AdvAPI32{LoadLibraryW(L"advapi32.dll")};
+static HMODULE Kernel32{LoadLibraryW(L"kernel32.dll")};
+static HMODULE Ws2_32{LoadLibraryW(L"ws2_32.dll")};
 
 /**
  * @brief Instances of the mock's Guard class members
@@ -37,6 +40,40 @@ DEFINE_GUARD(Mocks, RegCreateKeyExW);
 DEFINE_GUARD(Mocks, RegDeleteValueW);
 DEFINE_GUARD(Mocks, RegOpenKeyW);
 DEFINE_GUARD(Mocks, RegSetValueExW);
+DEFINE_GUARD(Mocks, CreateFileW);
+DEFINE_GUARD(Mocks, ReadFile);
+DEFINE_GUARD(Mocks, WriteFile);
+DEFINE_GUARD(Mocks, CloseHandle);
+DEFINE_GUARD(Mocks, CreateIoCompletionPort);
+DEFINE_GUARD(Mocks, GetQueuedCompletionStatus);
+DEFINE_GUARD(Mocks, PostQueuedCompletionStatus);
+DEFINE_GUARD(Mocks, GetOverlappedResult);
+DEFINE_GUARD(Mocks, CancelIoEx);
+DEFINE_GUARD(Mocks, CreateThread);
+DEFINE_GUARD(Mocks, ResumeThread);
+DEFINE_GUARD(Mocks, GetExitCodeThread);
+DEFINE_GUARD(Mocks, EnterCriticalSection);
+DEFINE_GUARD(Mocks, LeaveCriticalSection);
+DEFINE_GUARD(Mocks, AcquireSRWLockExclusive);
+DEFINE_GUARD(Mocks, ReleaseSRWLockExclusive);
+DEFINE_GUARD(Mocks, AcquireSRWLockShared);
+DEFINE_GUARD(Mocks, ReleaseSRWLockShared);
+DEFINE_GUARD(Mocks, WaitForSingleObject);
+DEFINE_GUARD(Mocks, socket);
+DEFINE_GUARD(Mocks, bind);
+DEFINE_GUARD(Mocks, listen);
+DEFINE_GUARD(Mocks, accept);
+DEFINE_GUARD(Mocks, connect);
+DEFINE_GUARD(Mocks, send);
+DEFINE_GUARD(Mocks, recv);
+DEFINE_GUARD(Mocks, closesocket);
+DEFINE_GUARD(Mocks, ioctlsocket);
+DEFINE_GUARD(Mocks, WSAPoll);
+
+/**
+ * @brief Instance of the global mock registry
+ */
+DEFINE_MOCK_REGISTRY();
 
 /**
  * @brief Instances of the mock's static members
@@ -47,6 +84,50 @@ DEFINE_MOCK(RegCreateKeyExW, LSTATUS, ERROR_REGISTRY_CORRUPT, NO_ERROR);
 DEFINE_MOCK(RegDeleteValueW, LSTATUS, ERROR_REGISTRY_CORRUPT, NO_ERROR);
 DEFINE_MOCK(RegOpenKeyW, LSTATUS, ERROR_REGISTRY_IO_FAILED, NO_ERROR);
 DEFINE_MOCK(RegSetValueExW, LSTATUS, ERROR_REGISTRY_CORRUPT, NO_ERROR);
+DEFINE_MOCK(CreateFileW, HANDLE, -1, ERROR_FILE_NOT_FOUND);
+DEFINE_MOCK(ReadFile, BOOL, FALSE, ERROR_READ_FAULT);
+DEFINE_MOCK(WriteFile, BOOL, FALSE, ERROR_WRITE_FAULT);
+DEFINE_MOCK(CloseHandle, BOOL, FALSE, ERROR_INVALID_HANDLE);
+DEFINE_MOCK(CreateIoCompletionPort, HANDLE, 0, ERROR_INVALID_PARAMETER);
+DEFINE_MOCK(GetQueuedCompletionStatus, BOOL, FALSE, ERROR_INVALID_HANDLE);
+DEFINE_MOCK(PostQueuedCompletionStatus, BOOL, FALSE, ERROR_INVALID_HANDLE);
+DEFINE_MOCK(GetOverlappedResult, BOOL, FALSE, ERROR_IO_INCOMPLETE);
+DEFINE_MOCK(CancelIoEx, BOOL, FALSE, ERROR_NOT_FOUND);
+DEFINE_MOCK(CreateThread, HANDLE, 0, ERROR_NOT_ENOUGH_MEMORY);
+DEFINE_MOCK(ResumeThread, DWORD, DWORD(-1), ERROR_INVALID_HANDLE);
+DEFINE_MOCK(GetExitCodeThread, BOOL, FALSE, ERROR_INVALID_HANDLE);
+DEFINE_MOCK(EnterCriticalSection, VOID, 0, NO_ERROR);
+DEFINE_MOCK(LeaveCriticalSection, VOID, 0, NO_ERROR);
+DEFINE_MOCK(AcquireSRWLockExclusive, VOID, 0, NO_ERROR);
+DEFINE_MOCK(ReleaseSRWLockExclusive, VOID, 0, NO_ERROR);
+DEFINE_MOCK(AcquireSRWLockShared, VOID, 0, NO_ERROR);
+DEFINE_MOCK(ReleaseSRWLockShared, VOID, 0, NO_ERROR);
+DEFINE_MOCK(WaitForSingleObject, DWORD, WAIT_FAILED, ERROR_INVALID_HANDLE);
+DEFINE_MOCK(socket, SOCKET, INVALID_SOCKET, WSAENETDOWN);
+DEFINE_MOCK(bind, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(listen, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(accept, SOCKET, INVALID_SOCKET, WSAENETDOWN);
+DEFINE_MOCK(connect, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(send, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(recv, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(closesocket, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(ioctlsocket, int, SOCKET_ERROR, WSAENETDOWN);
+DEFINE_MOCK(WSAPoll, int, SOCKET_ERROR, WSAENETDOWN);
+
+/**
+ * @brief Mocks which can be controlled by a test process
+ */
+DEFINE_CONTROL(Mocks, RegCloseKey);
+DEFINE_CONTROL(Mocks, RegCreateKeyW);
+DEFINE_CONTROL(Mocks, RegCreateKeyExW);
+DEFINE_CONTROL(Mocks, RegDeleteValueW);
+DEFINE_CONTROL(Mocks, RegOpenKeyW);
+DEFINE_CONTROL(Mocks, RegSetValueExW);
+
+/**
+ * @brief Serve commands when spawned by ffmock::control::Controller
+ */
+static ffmock::control::Server ControlServer;
 
 
 extern "C"
@@ -166,4 +247,539 @@ catch(std::bad_alloc const&)
     return ERROR_OUTOFMEMORY;
 }
 
+/*****************************************************************
+ * @brief Mocked APIs for files
+ *****************************************************************/
+
+FFMOCK_IMPORT
+HANDLE
+WINAPI
+CreateFileW(
+    _In_     LPCWSTR FileName,
+    _In_     DWORD DesiredAccess,
+    _In_     DWORD ShareMode,
+    _In_opt_ LPSECURITY_ATTRIBUTES SecurityAttributes,
+    _In_     DWORD CreationDisposition,
+    _In_     DWORD FlagsAndAttributes,
+    _In_opt_ HANDLE TemplateFile
+    ) try
+{
+    static Mocks::FFCreateFileW mock(Kernel32);
+    return mock(FileName, DesiredAccess, ShareMode, SecurityAttributes,
+                CreationDisposition, FlagsAndAttributes, TemplateFile);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return INVALID_HANDLE_VALUE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+ReadFile(
+    _In_ HANDLE File,
+    _Out_writes_bytes_to_opt_(NumberOfBytesToRead, *NumberOfBytesRead) __out_data_source(FILE) LPVOID Buffer,
+    _In_ DWORD NumberOfBytesToRead,
+    _Out_opt_ LPDWORD NumberOfBytesRead,
+    _Inout_opt_ LPOVERLAPPED Overlapped
+    ) try
+{
+    static Mocks::FFReadFile mock(Kernel32);
+    return mock(File, Buffer, NumberOfBytesToRead, NumberOfBytesRead, Overlapped);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+WriteFile(
+    _In_ HANDLE File,
+    _In_reads_bytes_opt_(NumberOfBytesToWrite) LPCVOID Buffer,
+    _In_ DWORD NumberOfBytesToWrite,
+    _Out_opt_ LPDWORD NumberOfBytesWritten,
+    _Inout_opt_ LPOVERLAPPED Overlapped
+    ) try
+{
+    static Mocks::FFWriteFile mock(Kernel32);
+    return mock(File, Buffer, NumberOfBytesToWrite, NumberOfBytesWritten, Overlapped);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+CloseHandle(
+    _In_ _Post_ptr_invalid_ HANDLE Object
+    ) try
+{
+    static Mocks::FFCloseHandle mock(Kernel32);
+    return mock(Object);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+HANDLE
+WINAPI
+CreateIoCompletionPort(
+    _In_     HANDLE FileHandle,
+    _In_opt_ HANDLE ExistingCompletionPort,
+    _In_     ULONG_PTR CompletionKey,
+    _In_     DWORD NumberOfConcurrentThreads
+    ) try
+{
+    static Mocks::FFCreateIoCompletionPort mock(Kernel32);
+    return mock(FileHandle, ExistingCompletionPort, CompletionKey, NumberOfConcurrentThreads);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return nullptr;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+GetQueuedCompletionStatus(
+    _In_  HANDLE CompletionPort,
+    _Out_ LPDWORD NumberOfBytesTransferred,
+    _Out_ PULONG_PTR CompletionKey,
+    _Out_ LPOVERLAPPED* Overlapped,
+    _In_  DWORD Milliseconds
+    ) try
+{
+    static Mocks::FFGetQueuedCompletionStatus mock(Kernel32);
+    return mock(CompletionPort, NumberOfBytesTransferred, CompletionKey, Overlapped, Milliseconds);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+PostQueuedCompletionStatus(
+    _In_     HANDLE CompletionPort,
+    _In_     DWORD NumberOfBytesTransferred,
+    _In_     ULONG_PTR CompletionKey,
+    _In_opt_ LPOVERLAPPED Overlapped
+    ) try
+{
+    static Mocks::FFPostQueuedCompletionStatus mock(Kernel32);
+    return mock(CompletionPort, NumberOfBytesTransferred, CompletionKey, Overlapped);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+GetOverlappedResult(
+    _In_  HANDLE File,
+    _In_  LPOVERLAPPED Overlapped,
+    _Out_ LPDWORD NumberOfBytesTransferred,
+    _In_  BOOL Wait
+    ) try
+{
+    static Mocks::FFGetOverlappedResult mock(Kernel32);
+    return mock(File, Overlapped, NumberOfBytesTransferred, Wait);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+CancelIoEx(
+    _In_     HANDLE File,
+    _In_opt_ LPOVERLAPPED Overlapped
+    ) try
+{
+    static Mocks::FFCancelIoEx mock(Kernel32);
+    return mock(File, Overlapped);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+/*****************************************************************
+ * @brief Mocked APIs for threads
+ *****************************************************************/
+
+FFMOCK_IMPORT
+HANDLE
+WINAPI
+CreateThread(
+    _In_opt_  LPSECURITY_ATTRIBUTES ThreadAttributes,
+    _In_      SIZE_T StackSize,
+    _In_      LPTHREAD_START_ROUTINE StartAddress,
+    _In_opt_ __drv_aliasesMem LPVOID Parameter,
+    _In_      DWORD CreationFlags,
+    _Out_opt_ LPDWORD ThreadId
+    ) try
+{
+    static Mocks::FFCreateThread mock(Kernel32);
+    return mock(ThreadAttributes, StackSize, StartAddress, Parameter, CreationFlags, ThreadId);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return nullptr;
+}
+
+FFMOCK_IMPORT
+DWORD
+WINAPI
+ResumeThread(
+    _In_ HANDLE Thread
+    ) try
+{
+    static Mocks::FFResumeThread mock(Kernel32);
+    return mock(Thread);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return DWORD(-1);
+}
+
+FFMOCK_IMPORT
+BOOL
+WINAPI
+GetExitCodeThread(
+    _In_  HANDLE Thread,
+    _Out_ LPDWORD ExitCode
+    ) try
+{
+    static Mocks::FFGetExitCodeThread mock(Kernel32);
+    return mock(Thread, ExitCode);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return FALSE;
+}
+
+/*****************************************************************
+ * @brief Mocked APIs for synchronization
+ *****************************************************************/
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+EnterCriticalSection(
+    _Inout_ LPCRITICAL_SECTION CriticalSection
+    ) try
+{
+    static Mocks::FFEnterCriticalSection mock(Kernel32);
+    mock(CriticalSection);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFEnterCriticalSection::Real(CriticalSection);
+}
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+LeaveCriticalSection(
+    _Inout_ LPCRITICAL_SECTION CriticalSection
+    ) try
+{
+    static Mocks::FFLeaveCriticalSection mock(Kernel32);
+    mock(CriticalSection);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFLeaveCriticalSection::Real(CriticalSection);
+}
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+AcquireSRWLockExclusive(
+    _Inout_ PSRWLOCK SRWLock
+    ) try
+{
+    static Mocks::FFAcquireSRWLockExclusive mock(Kernel32);
+    mock(SRWLock);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFAcquireSRWLockExclusive::Real(SRWLock);
+}
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+ReleaseSRWLockExclusive(
+    _Inout_ PSRWLOCK SRWLock
+    ) try
+{
+    static Mocks::FFReleaseSRWLockExclusive mock(Kernel32);
+    mock(SRWLock);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFReleaseSRWLockExclusive::Real(SRWLock);
+}
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+AcquireSRWLockShared(
+    _Inout_ PSRWLOCK SRWLock
+    ) try
+{
+    static Mocks::FFAcquireSRWLockShared mock(Kernel32);
+    mock(SRWLock);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFAcquireSRWLockShared::Real(SRWLock);
+}
+
+FFMOCK_IMPORT
+VOID
+WINAPI
+ReleaseSRWLockShared(
+    _Inout_ PSRWLOCK SRWLock
+    ) try
+{
+    static Mocks::FFReleaseSRWLockShared mock(Kernel32);
+    mock(SRWLock);
+}
+catch(std::bad_alloc const&)
+{
+    // The API can't fail
+    Mocks::FFReleaseSRWLockShared::Real(SRWLock);
+}
+
+FFMOCK_IMPORT
+DWORD
+WINAPI
+WaitForSingleObject(
+    _In_ HANDLE Handle,
+    _In_ DWORD Milliseconds
+    ) try
+{
+    static Mocks::FFWaitForSingleObject mock(Kernel32);
+    return mock(Handle, Milliseconds);
+}
+catch(std::bad_alloc const&)
+{
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return WAIT_FAILED;
+}
+
+/*****************************************************************
+ * @brief Mocked APIs for sockets
+ *****************************************************************/
+
+FFMOCK_IMPORT
+SOCKET
+WSAAPI
+socket(
+    _In_ int Family,
+    _In_ int Type,
+    _In_ int Protocol
+    ) try
+{
+    static Mocks::FFsocket mock(Ws2_32);
+    return mock(Family, Type, Protocol);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return INVALID_SOCKET;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+bind(
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(NameLength) const sockaddr* Name,
+    _In_ int NameLength
+    ) try
+{
+    static Mocks::FFbind mock(Ws2_32);
+    return mock(Socket, Name, NameLength);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+listen(
+    _In_ SOCKET Socket,
+    _In_ int Backlog
+    ) try
+{
+    static Mocks::FFlisten mock(Ws2_32);
+    return mock(Socket, Backlog);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+SOCKET
+WSAAPI
+accept(
+    _In_ SOCKET Socket,
+    _Out_writes_bytes_opt_(*AddressLength) sockaddr* Address,
+    _Inout_opt_ int* AddressLength
+    ) try
+{
+    static Mocks::FFaccept mock(Ws2_32);
+    return mock(Socket, Address, AddressLength);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return INVALID_SOCKET;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+connect(
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(NameLength) const sockaddr* Name,
+    _In_ int NameLength
+    ) try
+{
+    static Mocks::FFconnect mock(Ws2_32);
+    return mock(Socket, Name, NameLength);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+send(
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(Length) const char* Buffer,
+    _In_ int Length,
+    _In_ int Flags
+    ) try
+{
+    static Mocks::FFsend mock(Ws2_32);
+    return mock(Socket, Buffer, Length, Flags);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+recv(
+    _In_ SOCKET Socket,
+    _Out_writes_bytes_to_(Length, return) __out_data_source(NETWORK) char* Buffer,
+    _In_ int Length,
+    _In_ int Flags
+    ) try
+{
+    static Mocks::FFrecv mock(Ws2_32);
+    return mock(Socket, Buffer, Length, Flags);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+closesocket(
+    _In_ SOCKET Socket
+    ) try
+{
+    static Mocks::FFclosesocket mock(Ws2_32);
+    return mock(Socket);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+ioctlsocket(
+    _In_ SOCKET Socket,
+    _In_ long Command,
+    _Inout_ u_long* Argument
+    ) try
+{
+    static Mocks::FFioctlsocket mock(Ws2_32);
+    return mock(Socket, Command, Argument);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
+FFMOCK_IMPORT
+int
+WSAAPI
+WSAPoll(
+    _Inout_ LPWSAPOLLFD Sockets,
+    _In_ ULONG Count,
+    _In_ INT Timeout
+    ) try
+{
+    static Mocks::FFWSAPoll mock(Ws2_32);
+    return mock(Sockets, Count, Timeout);
+}
+catch(std::bad_alloc const&)
+{
+    WSASetLastError(WSA_NOT_ENOUGH_MEMORY);
+    return SOCKET_ERROR;
+}
+
 } // extern "C"
@@ -24,10 +24,19 @@
 
 #pragma once
 
+#include <ffmock/sockets.h>
 #include <ffmock/ffmock.h>
 #include <Common.hpp>
+#include <ffmock/memfs.h>
+#include <ffmock/async.h>
+#include <ffmock/threads.h>
+#include <ffmock/contention.h>
+#include <ffmock/interleave.h>
 #include <winsvc.h>
 #include <winreg.h>
+#include <fileapi.h>
+#include <handleapi.h>
+#include <ioapiset.h>
 
 
 namespace Mocks
@@ -42,7 +51,7 @@ namespace Mocks
  * @see https://learn.microsoft.com/en-us/windows/win32/api/winreg/nf-winreg-regclosekey
  */
 class FFRegCloseKey
-    : public ::ffmock::Mock<LSTATUS, decltype(::RegCloseKey), ERROR_INVALID_HANDLE>
+    : public MOCK_TYPE(RegCloseKey, LSTATUS, ERROR_INVALID_HANDLE, NO_ERROR)
 {
     friend
     FFMOCK_IMPORT
@@ -120,4 +129,367 @@ DECLARE_MOCK(RegSetValueExW, LSTATUS, ERROR_REGISTRY_CORRUPT, NO_ERROR, APIENTRY
     _In_       DWORD DataCount
     ));
 
+/*****************************************************************
+ * @brief Mocked APIs for files
+ *
+ * @details Kernel32 APIs can't be replaced at link time, so their
+ *          names are always mangled (see FILE_MOCKS_DEFINITIONS).
+ *****************************************************************/
+
+/**
+ * @brief Mock for CreateFileW
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/fileapi/nf-fileapi-createfilew
+ *
+ * @note The default failing result -1 is converted to HANDLE, so the failing mock
+ *       returns INVALID_HANDLE_VALUE.
+ */
+DECLARE_MOCK(CreateFileW, HANDLE, -1, ERROR_FILE_NOT_FOUND, WINAPI,
+    (
+    _In_     LPCWSTR FileName,
+    _In_     DWORD DesiredAccess,
+    _In_     DWORD ShareMode,
+    _In_opt_ LPSECURITY_ATTRIBUTES SecurityAttributes,
+    _In_     DWORD CreationDisposition,
+    _In_     DWORD FlagsAndAttributes,
+    _In_opt_ HANDLE TemplateFile
+    ));
+
+/**
+ * @brief Mock for ReadFile
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/fileapi/nf-fileapi-readfile
+ */
+DECLARE_MOCK(ReadFile, BOOL, FALSE, ERROR_READ_FAULT, WINAPI,
+    (
+    _In_ HANDLE File,
+    _Out_writes_bytes_to_opt_(NumberOfBytesToRead, *NumberOfBytesRead) __out_data_source(FILE) LPVOID Buffer,
+    _In_ DWORD NumberOfBytesToRead,
+    _Out_opt_ LPDWORD NumberOfBytesRead,
+    _Inout_opt_ LPOVERLAPPED Overlapped
+    ));
+
+/**
+ * @brief Mock for WriteFile
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/fileapi/nf-fileapi-writefile
+ */
+DECLARE_MOCK(WriteFile, BOOL, FALSE, ERROR_WRITE_FAULT, WINAPI,
+    (
+    _In_ HANDLE File,
+    _In_reads_bytes_opt_(NumberOfBytesToWrite) LPCVOID Buffer,
+    _In_ DWORD NumberOfBytesToWrite,
+    _Out_opt_ LPDWORD NumberOfBytesWritten,
+    _Inout_opt_ LPOVERLAPPED Overlapped
+    ));
+
+/**
+ * @brief Mock for CloseHandle
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/handleapi/nf-handleapi-closehandle
+ */
+DECLARE_MOCK(CloseHandle, BOOL, FALSE, ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_ _Post_ptr_invalid_ HANDLE Object
+    ));
+
+/**
+ * @brief Mock for CreateIoCompletionPort
+ * @see https://learn.microsoft.com/en-us/windows/win32/fileio/createiocompletionport
+ */
+DECLARE_MOCK(CreateIoCompletionPort, HANDLE, 0, ERROR_INVALID_PARAMETER, WINAPI,
+    (
+    _In_     HANDLE FileHandle,
+    _In_opt_ HANDLE ExistingCompletionPort,
+    _In_     ULONG_PTR CompletionKey,
+    _In_     DWORD NumberOfConcurrentThreads
+    ));
+
+/**
+ * @brief Mock for GetQueuedCompletionStatus
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/ioapiset/nf-ioapiset-getqueuedcompletionstatus
+ */
+DECLARE_MOCK(GetQueuedCompletionStatus, BOOL, FALSE, ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_  HANDLE CompletionPort,
+    _Out_ LPDWORD NumberOfBytesTransferred,
+    _Out_ PULONG_PTR CompletionKey,
+    _Out_ LPOVERLAPPED* Overlapped,
+    _In_  DWORD Milliseconds
+    ));
+
+/**
+ * @brief Mock for PostQueuedCompletionStatus
+ * @see https://learn.microsoft.com/en-us/windows/win32/fileio/postqueuedcompletionstatus
+ */
+DECLARE_MOCK(PostQueuedCompletionStatus, BOOL, FALSE, ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_     HANDLE CompletionPort,
+    _In_     DWORD NumberOfBytesTransferred,
+    _In_     ULONG_PTR CompletionKey,
+    _In_opt_ LPOVERLAPPED Overlapped
+    ));
+
+/**
+ * @brief Mock for GetOverlappedResult
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/ioapiset/nf-ioapiset-getoverlappedresult
+ */
+DECLARE_MOCK(GetOverlappedResult, BOOL, FALSE, ERROR_IO_INCOMPLETE, WINAPI,
+    (
+    _In_  HANDLE File,
+    _In_  LPOVERLAPPED Overlapped,
+    _Out_ LPDWORD NumberOfBytesTransferred,
+    _In_  BOOL Wait
+    ));
+
+/**
+ * @brief Mock for CancelIoEx
+ * @see https://learn.microsoft.com/en-us/windows/win32/fileio/cancelioex-func
+ */
+DECLARE_MOCK(CancelIoEx, BOOL, FALSE, ERROR_NOT_FOUND, WINAPI,
+    (
+    _In_     HANDLE File,
+    _In_opt_ LPOVERLAPPED Overlapped
+    ));
+
+/*****************************************************************
+ * @brief Mocked APIs for threads
+ *****************************************************************/
+
+/**
+ * @brief Mock for CreateThread
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-createthread
+ */
+DECLARE_MOCK(CreateThread, HANDLE, 0, ERROR_NOT_ENOUGH_MEMORY, WINAPI,
+    (
+    _In_opt_  LPSECURITY_ATTRIBUTES ThreadAttributes,
+    _In_      SIZE_T StackSize,
+    _In_      LPTHREAD_START_ROUTINE StartAddress,
+    _In_opt_ __drv_aliasesMem LPVOID Parameter,
+    _In_      DWORD CreationFlags,
+    _Out_opt_ LPDWORD ThreadId
+    ));
+
+/**
+ * @brief Mock for ResumeThread
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-resumethread
+ */
+DECLARE_MOCK(ResumeThread, DWORD, DWORD(-1), ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_ HANDLE Thread
+    ));
+
+/**
+ * @brief Mock for GetExitCodeThread
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-getexitcodethread
+ */
+DECLARE_MOCK(GetExitCodeThread, BOOL, FALSE, ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_  HANDLE Thread,
+    _Out_ LPDWORD ExitCode
+    ));
+
+/*****************************************************************
+ * @brief Mocked APIs for synchronization
+ *****************************************************************/
+
+/**
+ * @brief Mock for EnterCriticalSection
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-entercriticalsection
+ */
+DECLARE_MOCK(EnterCriticalSection, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ LPCRITICAL_SECTION CriticalSection
+    ));
+
+/**
+ * @brief Mock for LeaveCriticalSection
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-leavecriticalsection
+ */
+DECLARE_MOCK(LeaveCriticalSection, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ LPCRITICAL_SECTION CriticalSection
+    ));
+
+/**
+ * @brief Mock for AcquireSRWLockExclusive
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-acquiresrwlockexclusive
+ */
+DECLARE_MOCK(AcquireSRWLockExclusive, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ PSRWLOCK SRWLock
+    ));
+
+/**
+ * @brief Mock for ReleaseSRWLockExclusive
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-releasesrwlockexclusive
+ */
+DECLARE_MOCK(ReleaseSRWLockExclusive, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ PSRWLOCK SRWLock
+    ));
+
+/**
+ * @brief Mock for AcquireSRWLockShared
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-acquiresrwlockshared
+ */
+DECLARE_MOCK(AcquireSRWLockShared, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ PSRWLOCK SRWLock
+    ));
+
+/**
+ * @brief Mock for ReleaseSRWLockShared
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-releasesrwlockshared
+ */
+DECLARE_MOCK(ReleaseSRWLockShared, VOID, 0, NO_ERROR, WINAPI,
+    (
+    _Inout_ PSRWLOCK SRWLock
+    ));
+
+/**
+ * @brief Mock for WaitForSingleObject
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-waitforsingleobject
+ */
+DECLARE_MOCK(WaitForSingleObject, DWORD, WAIT_FAILED, ERROR_INVALID_HANDLE, WINAPI,
+    (
+    _In_ HANDLE Handle,
+    _In_ DWORD Milliseconds
+    ));
+
+/*****************************************************************
+ * @brief Mocked APIs for sockets
+ *****************************************************************/
+
+/**
+ * @brief Mock for socket
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-socket
+ */
+DECLARE_MOCK(socket, SOCKET, INVALID_SOCKET, WSAENETDOWN, WSAAPI,
+    (
+    _In_ int Family,
+    _In_ int Type,
+    _In_ int Protocol
+    ));
+
+/**
+ * @brief Mock for bind
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-bind
+ */
+DECLARE_MOCK(bind, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(NameLength) const sockaddr* Name,
+    _In_ int NameLength
+    ));
+
+/**
+ * @brief Mock for listen
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-listen
+ */
+DECLARE_MOCK(listen, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _In_ int Backlog
+    ));
+
+/**
+ * @brief Mock for accept
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-accept
+ */
+DECLARE_MOCK(accept, SOCKET, INVALID_SOCKET, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _Out_writes_bytes_opt_(*AddressLength) sockaddr* Address,
+    _Inout_opt_ int* AddressLength
+    ));
+
+/**
+ * @brief Mock for connect
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-connect
+ */
+DECLARE_MOCK(connect, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(NameLength) const sockaddr* Name,
+    _In_ int NameLength
+    ));
+
+/**
+ * @brief Mock for send
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-send
+ */
+DECLARE_MOCK(send, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _In_reads_bytes_(Length) const char* Buffer,
+    _In_ int Length,
+    _In_ int Flags
+    ));
+
+/**
+ * @brief Mock for recv
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-recv
+ */
+DECLARE_MOCK(recv, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _Out_writes_bytes_to_(Length, return) __out_data_source(NETWORK) char* Buffer,
+    _In_ int Length,
+    _In_ int Flags
+    ));
+
+/**
+ * @brief Mock for closesocket
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-closesocket
+ */
+DECLARE_MOCK(closesocket, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket
+    ));
+
+/**
+ * @brief Mock for ioctlsocket
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-ioctlsocket
+ */
+DECLARE_MOCK(ioctlsocket, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _In_ SOCKET Socket,
+    _In_ long Command,
+    _Inout_ u_long* Argument
+    ));
+
+/**
+ * @brief Mock for WSAPoll
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-wsapoll
+ */
+DECLARE_MOCK(WSAPoll, int, SOCKET_ERROR, WSAENETDOWN, WSAAPI,
+    (
+    _Inout_ LPWSAPOLLFD Sockets,
+    _In_ ULONG Count,
+    _In_ INT Timeout
+    ));
+
+//! @brief Redirect the socket APIs to an in-process network
+using NetworkMount = ::ffmock::sockets::Mount<FFsocket, FFbind, FFlisten, FFaccept, FFconnect,
+                                              FFsend, FFrecv, FFclosesocket, FFioctlsocket, FFWSAPoll>;
+
+//! @brief Redirect the file APIs to an in-memory filesystem
+using FileSystemMount = ::ffmock::memfs::Mount<FFCreateFileW, FFReadFile, FFWriteFile, FFCloseHandle>;
+
+//! @brief Redirect the file and I/O completion APIs to an in-memory filesystem with simulated asynchronous I/O
+using AsyncMount = ::ffmock::async::Mount<FFCreateFileW, FFReadFile, FFWriteFile, FFCloseHandle,
+                                          FFCreateIoCompletionPort, FFGetQueuedCompletionStatus,
+                                          FFPostQueuedCompletionStatus, FFGetOverlappedResult, FFCancelIoEx>;
+
+//! @brief Redirect thread creation to a pool of reusable workers
+using ThreadPoolMount = ::ffmock::threads::Mount<FFCreateThread, FFResumeThread, FFGetExitCodeThread,
+                                                 FFCloseHandle>;
+
+//! @brief Profile the locks taken through the synchronization APIs
+using ContentionMount = ::ffmock::contention::Mount<FFEnterCriticalSection, FFLeaveCriticalSection,
+                                                    FFAcquireSRWLockExclusive, FFReleaseSRWLockExclusive,
+                                                    FFAcquireSRWLockShared, FFReleaseSRWLockShared,
+                                                    FFWaitForSingleObject>;
+
+//! @brief Make the blocking synchronization APIs yield to the interleaving scheduler
+using InterleaveMount = ::ffmock::interleave::Mount<FFEnterCriticalSection, FFAcquireSRWLockExclusive,
+                                                    FFAcquireSRWLockShared, FFWaitForSingleObject>;
+
 } // namespace Mocks
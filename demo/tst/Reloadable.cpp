@@ -0,0 +1,76 @@
+/**
+  @brief Mocks implementations loaded by the hot reload unit tests
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#include <windef.h>
+#include <winbase.h>
+#include <winreg.h>
+#include <synchapi.h>
+
+/**
+ * @brief Status returned by this version of the library
+ *
+ * @details The library is built twice (see CMakeLists.txt), so the tests can
+ *          replace one version with the other.
+ */
+#if RELOADABLE_VERSION == 1
+constexpr LSTATUS Status_k = ERROR_ACCESS_DENIED;
+#else
+constexpr LSTATUS Status_k = ERROR_FILE_NOT_FOUND;
+#endif
+
+/**
+ * @brief Mock of RegOpenKeyW
+ */
+extern "C"
+LSTATUS
+APIENTRY
+Mock_RegOpenKeyW(
+    _In_     HKEY    /*Key*/,
+    _In_opt_ LPCWSTR /*SubKey*/,
+    _Out_    PHKEY   Result
+    )
+{
+    // Undecorated export, for GetProcAddress() on x86 too
+#pragma comment(linker, "/EXPORT:" __FUNCTION__ "=" __FUNCDNAME__)
+    *Result = nullptr;
+    return Status_k;
+}
+
+/**
+ * @brief Mock of RegDeleteValueW
+ *
+ * @details The key is an event, which the call waits for before returning.
+ */
+extern "C"
+LSTATUS
+APIENTRY
+Mock_RegDeleteValueW(
+    _In_     HKEY    Key,
+    _In_opt_ LPCWSTR /*ValueName*/
+    )
+{
+#pragma comment(linker, "/EXPORT:" __FUNCTION__ "=" __FUNCDNAME__)
+    WaitForSingleObject(reinterpret_cast<HANDLE>(Key), INFINITE);
+    return Status_k;
+}
@@ -0,0 +1,844 @@
+/**
+  @brief Simulated asynchronous I/O
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <ffmock/handles.h>
+#include <ffmock/memfs.h>
+#include <errhandlingapi.h>
+#include <ioapiset.h>
+#include <synchapi.h>
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace ffmock
+{
+namespace async
+{
+
+//! @brief Maximum number of open completion ports
+constexpr ULONG Ports_k = 64;
+
+/**
+ * @brief Rules of the completion scheduler
+ *
+ * @details Delays are in virtual milliseconds. All random choices are taken
+ *          from a generator seeded with Seed, so a run can be repeated exactly.
+ */
+struct Policy
+{
+    ULONG Seed{1};              //!< Seed of the random choices
+    ULONGLONG MinDelay{};       //!< Minimum time from submission to completion
+    ULONGLONG MaxDelay{};       //!< Maximum time from submission to completion
+    bool Reorder{};             //!< Complete due operations in random order
+    ULONG Batch{ULONG_MAX};     //!< Maximum number of operations completed by a step
+    ULONG Partial{};            //!< Percent of the transfers cut short
+    bool AutoAdvance{true};     //!< Advance the clock when a caller waits for a completion
+};
+
+/**
+ * @brief Data transfer performed when an operation completes
+ *
+ * @param Bytes - Number of bytes to transfer
+ * @param Transferred - Number of bytes transferred
+ *
+ * @return DWORD - Error code, or NO_ERROR
+ */
+using Transfer_t = std::function<DWORD(DWORD Bytes, DWORD& Transferred)>;
+
+/**
+ * @brief Deterministic scheduler of overlapped I/O completions
+ *
+ * @details Submitted operations are queued with a due time on a virtual clock.
+ *          The test completes them explicitly (Complete(), Step(), Advance(), Run()),
+ *          or, with Policy::AutoAdvance, a caller waiting for a completion moves
+ *          the clock to the next due operation. No real time passes, so large
+ *          workloads are simulated at full speed.
+ *          Completions are reported the way the kernel does: the OVERLAPPED status,
+ *          the event in OVERLAPPED::hEvent, and a packet in the completion port the
+ *          file is associated with. Waiters block on WaitOnAddress().
+ *
+ * @note With AutoAdvance, the order of completions is deterministic when a single
+ *       thread drives the I/O.
+ */
+class Engine
+{
+public:
+    explicit Engine(Policy Scheduling = Policy{})
+        : Rules(Scheduling)
+        , Random(Scheduling.Seed)
+    {
+    }
+
+    Engine(Engine const&) = delete;
+    Engine& operator=(Engine const&) = delete;
+
+    /*************************************************************
+     * @brief Test helpers
+     *************************************************************/
+
+    /**
+     * @brief Virtual time in milliseconds
+     */
+    ULONGLONG Now(void) const
+    {
+        return Clock.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of operations not completed yet
+     */
+    size_t Pending(void) const
+    {
+        Exclusive lock(Lock);
+        return Queue.size();
+    }
+
+    /**
+     * @brief Complete the next batch of due operations
+     *
+     * @details If no operation is due, the clock is advanced to the earliest one.
+     *
+     * @return size_t - Number of operations completed
+     */
+    size_t Step(void)
+    {
+        std::vector<Operation> batch;
+        {
+            Exclusive lock(Lock);
+            if (Queue.empty())
+            {
+                return 0;
+            }
+            const ULONGLONG due{Earliest()};
+            if (due > Clock.load())
+            {
+                Clock.store(due, std::memory_order_release);
+            }
+            batch = Take();
+        }
+        Finish(batch);
+        return batch.size();
+    }
+
+    /**
+     * @brief Advance the clock, completing all operations which become due
+     *
+     * @param Time - Virtual milliseconds to advance
+     */
+    void Advance(ULONGLONG Time)
+    {
+        Clock.fetch_add(Time, std::memory_order_acq_rel);
+        for (;;)
+        {
+            std::vector<Operation> batch;
+            {
+                Exclusive lock(Lock);
+                batch = Take();
+            }
+            if (batch.empty())
+            {
+                break;
+            }
+            Finish(batch);
+        }
+        Notify();
+    }
+
+    /**
+     * @brief Complete all the operations
+     *
+     * @return size_t - Number of operations completed
+     */
+    size_t Run(void)
+    {
+        size_t count{};
+        while (const size_t completed{Step()})
+        {
+            count += completed;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Complete an operation now, regardless of its due time
+     *
+     * @param Overlapped - The operation to complete
+     * @param Bytes - Maximum number of bytes to transfer (default to all)
+     * @param Error - Error to fail the operation with (no data is transferred)
+     *
+     * @return true if the operation was pending
+     */
+    bool Complete(LPOVERLAPPED Overlapped, DWORD Bytes = MAXDWORD, DWORD Error = NO_ERROR)
+    {
+        std::vector<Operation> batch;
+        {
+            Exclusive lock(Lock);
+            auto found = std::find_if(Queue.begin(), Queue.end(),
+                                      [Overlapped](Operation const& Entry) { return Entry.Overlapped == Overlapped; });
+            if (found == Queue.end())
+            {
+                return false;
+            }
+            batch.push_back(std::move(*found));
+            Queue.erase(found);
+        }
+        batch[0].Bytes = (std::min)(batch[0].Bytes, Bytes);
+        batch[0].Error = Error;
+        Finish(batch);
+        return true;
+    }
+
+    /*************************************************************
+     * @brief API implementations
+     *************************************************************/
+
+    /**
+     * @brief Queue an operation
+     *
+     * @details The caller fails the API with ERROR_IO_PENDING.
+     *
+     * @param File - Handle the operation was issued on
+     * @param Overlapped - OVERLAPPED of the operation
+     * @param Bytes - Number of bytes requested
+     * @param Transfer - Data transfer performed on completion
+     */
+    void Submit(HANDLE File, LPOVERLAPPED Overlapped, DWORD Bytes, Transfer_t Transfer)
+    {
+        Overlapped->Internal = STATUS_PENDING;
+        Overlapped->InternalHigh = 0;
+        if (HANDLE event{Event(Overlapped)})
+        {
+            ResetEvent(event);
+        }
+        Exclusive lock(Lock);
+        ULONGLONG delay{Rules.MinDelay};
+        if (Rules.MaxDelay > Rules.MinDelay)
+        {
+            delay += Random() % (Rules.MaxDelay - Rules.MinDelay + 1);
+        }
+        Queue.push_back(Operation{File, Overlapped, Bytes, std::move(Transfer),
+                                  Clock.load() + delay, Submitted++, NO_ERROR});
+    }
+
+    /**
+     * @brief Check if the handle is a completion port of the engine
+     */
+    static bool Owns(HANDLE Handle)
+    {
+        return handles::Is(Handle, handles::Kind::Port);
+    }
+
+    /**
+     * @brief Add a file opened with FILE_FLAG_OVERLAPPED
+     */
+    void Track(HANDLE File)
+    {
+        Exclusive lock(Lock);
+        Files.emplace(File, Binding{});
+    }
+
+    /**
+     * @brief Check if the file was opened with FILE_FLAG_OVERLAPPED
+     */
+    bool Tracked(HANDLE File) const
+    {
+        Exclusive lock(Lock);
+        return Files.count(File) != 0;
+    }
+
+    /**
+     * @brief Cancel the pending operations of a file being closed and forget it
+     */
+    void Release(HANDLE File)
+    {
+        Abort(File, nullptr);
+        Exclusive lock(Lock);
+        Files.erase(File);
+    }
+
+    /**
+     * @brief CreateIoCompletionPort() semantics
+     *
+     * @param File - Tracked file, or INVALID_HANDLE_VALUE to only create a port
+     * @param Existing - Port to associate the file with, or nullptr for a new port
+     * @param Key - Completion key of the file's packets
+     *
+     * @return HANDLE - The port, or nullptr on failure
+     */
+    HANDLE Associate(HANDLE File, HANDLE Existing, ULONG_PTR Key)
+    {
+        Exclusive lock(Lock);
+        HANDLE port{Existing};
+        if (port && !Open(port))
+        {
+            SetLastError(ERROR_INVALID_HANDLE);
+            return nullptr;
+        }
+        auto file = Files.end();
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            file = Files.find(File);
+            if (file == Files.end() || file->second.Port)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+                return nullptr;
+            }
+        }
+        if (!port)
+        {
+            ULONG slot{};
+            while (slot < Ports_k && Ports[slot].Open)
+            {
+                ++slot;
+            }
+            if (slot == Ports_k)
+            {
+                SetLastError(ERROR_NO_SYSTEM_RESOURCES);
+                return nullptr;
+            }
+            Ports[slot].Open = true;
+            port = handles::Make(handles::Kind::Port, slot);
+        }
+        if (file != Files.end())
+        {
+            file->second = Binding{port, Key};
+        }
+        return port;
+    }
+
+    /**
+     * @brief GetQueuedCompletionStatus() semantics, with Timeout in virtual time
+     */
+    BOOL Dequeue(HANDLE Port, LPDWORD Bytes, PULONG_PTR Key, LPOVERLAPPED* Overlapped, DWORD Timeout)
+    {
+        const ULONGLONG deadline{Timeout == INFINITE ? ULLONG_MAX : Now() + Timeout};
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            ULONGLONG due;
+            {
+                Exclusive lock(Lock);
+                if (!Open(Port))
+                {
+                    *Overlapped = nullptr;
+                    SetLastError(ERROR_INVALID_HANDLE);
+                    return FALSE;
+                }
+                std::deque<Packet>& packets{Ports[handles::Slot(Port)].Packets};
+                if (!packets.empty())
+                {
+                    const Packet packet{packets.front()};
+                    packets.pop_front();
+                    *Bytes = packet.Bytes;
+                    *Key = packet.Key;
+                    *Overlapped = packet.Overlapped;
+                    // Posted packets dequeue successfully, whatever their OVERLAPPED holds
+                    if (!packet.Posted && packet.Overlapped && packet.Overlapped->Internal)
+                    {
+                        SetLastError(Win32Error(packet.Overlapped->Internal));
+                        return FALSE;
+                    }
+                    return TRUE;
+                }
+                if (Clock.load() >= deadline)
+                {
+                    *Overlapped = nullptr;
+                    SetLastError(WAIT_TIMEOUT);
+                    return FALSE;
+                }
+                due = Earliest();
+            }
+            if (Rules.AutoAdvance)
+            {
+                // Don't advance the clock past the caller's deadline
+                if (due <= deadline)
+                {
+                    if (Step())
+                    {
+                        continue;
+                    }
+                }
+                else if (deadline != ULLONG_MAX)
+                {
+                    const ULONGLONG now{Now()};
+                    if (now < deadline)
+                    {
+                        Advance(deadline - now);
+                    }
+                    continue;
+                }
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+    }
+
+    /**
+     * @brief PostQueuedCompletionStatus() semantics
+     */
+    BOOL Post(HANDLE Port, DWORD Bytes, ULONG_PTR Key, LPOVERLAPPED Overlapped)
+    {
+        {
+            Exclusive lock(Lock);
+            if (!Open(Port))
+            {
+                SetLastError(ERROR_INVALID_HANDLE);
+                return FALSE;
+            }
+            Ports[handles::Slot(Port)].Packets.push_back(Packet{Bytes, Key, Overlapped, true});
+        }
+        Notify();
+        return TRUE;
+    }
+
+    /**
+     * @brief GetOverlappedResult() semantics
+     */
+    BOOL Result(LPOVERLAPPED Overlapped, LPDWORD Bytes, BOOL Wait)
+    {
+        ULONG_PTR status;
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            {
+                Exclusive lock(Lock);
+                status = Overlapped->Internal;
+                if (status != STATUS_PENDING)
+                {
+                    *Bytes = DWORD(Overlapped->InternalHigh);
+                    break;
+                }
+            }
+            if (!Wait)
+            {
+                SetLastError(ERROR_IO_INCOMPLETE);
+                return FALSE;
+            }
+            if (Rules.AutoAdvance && Step())
+            {
+                continue;
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+        if (status)
+        {
+            SetLastError(Win32Error(status));
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /**
+     * @brief CancelIoEx() semantics
+     */
+    BOOL Cancel(HANDLE File, LPOVERLAPPED Overlapped)
+    {
+        if (!Abort(File, Overlapped))
+        {
+            SetLastError(ERROR_NOT_FOUND);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /**
+     * @brief CloseHandle() of a completion port
+     */
+    BOOL Close(HANDLE Port)
+    {
+        {
+            Exclusive lock(Lock);
+            if (!Open(Port))
+            {
+                SetLastError(ERROR_INVALID_HANDLE);
+                return FALSE;
+            }
+            Ports[handles::Slot(Port)] = CompletionPort{};
+            for (auto& file : Files)
+            {
+                if (file.second.Port == Port)
+                {
+                    file.second = Binding{};
+                }
+            }
+        }
+        // Release the threads waiting on the port
+        Notify();
+        return TRUE;
+    }
+
+private:
+    struct Operation
+    {
+        HANDLE File;
+        LPOVERLAPPED Overlapped;
+        DWORD Bytes;
+        Transfer_t Transfer;
+        ULONGLONG Due;
+        ULONGLONG Sequence;
+        DWORD Error;
+    };
+
+    struct Packet
+    {
+        DWORD Bytes;
+        ULONG_PTR Key;
+        LPOVERLAPPED Overlapped;
+        bool Posted;    //!< Queued by PostQueuedCompletionStatus()
+    };
+
+    struct CompletionPort
+    {
+        bool Open{};
+        std::deque<Packet> Packets;
+    };
+
+    //! @brief Completion port a file is associated with
+    struct Binding
+    {
+        HANDLE Port{};
+        ULONG_PTR Key{};
+    };
+
+    //! @brief Scoped lock of the engine (a std::mutex, hidden from SRW lock API mocks)
+    using Exclusive = std::lock_guard<std::mutex>;
+
+    //! @brief Win32 errors are stored in OVERLAPPED::Internal as NTSTATUS (FACILITY_NTWIN32)
+    static ULONG_PTR NtStatus(DWORD Error)
+    {
+        return 0xC0070000UL | (Error & 0xFFFF);
+    }
+
+    static DWORD Win32Error(ULONG_PTR Status)
+    {
+        return DWORD(Status & 0xFFFF);
+    }
+
+    //! @brief Event to signal, unless the low bit is set to only skip the completion packet
+    static HANDLE Event(LPOVERLAPPED Overlapped)
+    {
+        return reinterpret_cast<HANDLE>(reinterpret_cast<ULONG_PTR>(Overlapped->hEvent) & ~ULONG_PTR(1));
+    }
+
+    //! @brief Check a port handle (requires the lock)
+    bool Open(HANDLE Port) const
+    {
+        return Owns(Port) && handles::Slot(Port) < Ports_k && Ports[handles::Slot(Port)].Open;
+    }
+
+    /**
+     * @brief Due time of the earliest queued operation, or ULLONG_MAX (requires the lock)
+     */
+    ULONGLONG Earliest(void) const
+    {
+        ULONGLONG due{ULLONG_MAX};
+        for (Operation const& operation : Queue)
+        {
+            due = (std::min)(due, operation.Due);
+        }
+        return due;
+    }
+
+    /**
+     * @brief Remove the next batch of due operations from the queue (requires the lock)
+     */
+    std::vector<Operation> Take(void)
+    {
+        std::vector<Operation> due;
+        const ULONGLONG now{Clock.load()};
+        for (auto operation = Queue.begin(); operation != Queue.end();)
+        {
+            if (operation->Due <= now)
+            {
+                due.push_back(std::move(*operation));
+                operation = Queue.erase(operation);
+            }
+            else
+            {
+                ++operation;
+            }
+        }
+        std::stable_sort(due.begin(), due.end(),
+                         [](Operation const& Left, Operation const& Right) { return Left.Due < Right.Due; });
+        if (Rules.Reorder)
+        {
+            for (size_t index = due.size(); index > 1; --index)
+            {
+                std::swap(due[index - 1], due[size_t(Random() % index)]);
+            }
+        }
+        // Operations beyond the batch stay queued for the next step
+        while (due.size() > Rules.Batch)
+        {
+            Queue.push_front(std::move(due.back()));
+            due.pop_back();
+        }
+        for (Operation& operation : due)
+        {
+            if (Rules.Partial && operation.Bytes > 1 && Random() % 100 < Rules.Partial)
+            {
+                operation.Bytes = 1 + DWORD(Random() % (operation.Bytes - 1));
+            }
+        }
+        return due;
+    }
+
+    /**
+     * @brief Transfer the data and report the completions
+     */
+    void Finish(std::vector<Operation>& Batch)
+    {
+        for (Operation& operation : Batch)
+        {
+            DWORD transferred{};
+            DWORD error{operation.Error};
+            if (!error && operation.Transfer)
+            {
+                error = operation.Transfer(operation.Bytes, transferred);
+            }
+            {
+                Exclusive lock(Lock);
+                LPOVERLAPPED overlapped{operation.Overlapped};
+                overlapped->InternalHigh = transferred;
+                overlapped->Internal = error ? NtStatus(error) : 0;
+                auto file = Files.find(operation.File);
+                if (file != Files.end() && file->second.Port &&
+                    !(reinterpret_cast<ULONG_PTR>(overlapped->hEvent) & 1))
+                {
+                    Ports[handles::Slot(file->second.Port)].Packets.push_back(
+                        Packet{transferred, file->second.Key, overlapped, false});
+                }
+            }
+            if (HANDLE event{Event(operation.Overlapped)})
+            {
+                SetEvent(event);
+            }
+        }
+        if (!Batch.empty())
+        {
+            Notify();
+        }
+    }
+
+    /**
+     * @brief Complete the pending operations of a file with ERROR_OPERATION_ABORTED
+     *
+     * @param File - The file
+     * @param Overlapped - The operation to cancel, or nullptr for all
+     *
+     * @return true if any operation was cancelled
+     */
+    bool Abort(HANDLE File, LPOVERLAPPED Overlapped)
+    {
+        std::vector<Operation> cancelled;
+        {
+            Exclusive lock(Lock);
+            for (auto operation = Queue.begin(); operation != Queue.end();)
+            {
+                if (operation->File == File && (!Overlapped || operation->Overlapped == Overlapped))
+                {
+                    cancelled.push_back(std::move(*operation));
+                    cancelled.back().Error = ERROR_OPERATION_ABORTED;
+                    operation = Queue.erase(operation);
+                }
+                else
+                {
+                    ++operation;
+                }
+            }
+        }
+        Finish(cancelled);
+        return !cancelled.empty();
+    }
+
+    void Notify(void)
+    {
+        Signal.fetch_add(1, std::memory_order_release);
+        WakeByAddressAll(&Signal);
+    }
+
+    const Policy Rules;
+    std::mt19937_64 Random;
+    mutable std::mutex Lock;
+    std::atomic<ULONGLONG> Clock{};
+    //! @brief Bumped on every completion, post and clock change
+    std::atomic<LONG> Signal{};
+    ULONGLONG Submitted{};
+    std::deque<Operation> Queue;
+    std::unordered_map<HANDLE, Binding> Files;
+    CompletionPort Ports[Ports_k];
+};
+
+/**
+ * @brief Redirect the file and I/O completion APIs mocks to an in-memory filesystem
+ *        with simulated asynchronous I/O
+ *
+ * @details Files opened with FILE_FLAG_OVERLAPPED read and write through the engine
+ *          when an OVERLAPPED is passed. All completion ports created while mounted
+ *          are simulated. Other handles are passed to the real APIs.
+ *
+ * @tparam CreateFileW_t - Mock class of CreateFileW()
+ * @tparam ReadFile_t - Mock class of ReadFile()
+ * @tparam WriteFile_t - Mock class of WriteFile()
+ * @tparam CloseHandle_t - Mock class of CloseHandle()
+ * @tparam CreateIoCompletionPort_t - Mock class of CreateIoCompletionPort()
+ * @tparam GetQueuedCompletionStatus_t - Mock class of GetQueuedCompletionStatus()
+ * @tparam PostQueuedCompletionStatus_t - Mock class of PostQueuedCompletionStatus()
+ * @tparam GetOverlappedResult_t - Mock class of GetOverlappedResult()
+ * @tparam CancelIoEx_t - Mock class of CancelIoEx()
+ */
+template<typename CreateFileW_t, typename ReadFile_t, typename WriteFile_t, typename CloseHandle_t,
+         typename CreateIoCompletionPort_t, typename GetQueuedCompletionStatus_t,
+         typename PostQueuedCompletionStatus_t, typename GetOverlappedResult_t, typename CancelIoEx_t>
+class Mount
+{
+    using FileSystem = memfs::FileSystem;
+
+public:
+    Mount(FileSystem& Files, Engine& Io)
+        : CreateFileGuard([&Files, &Io](LPCWSTR Name, DWORD Access, DWORD, LPSECURITY_ATTRIBUTES,
+                                        DWORD Disposition, DWORD Flags, HANDLE) -> HANDLE
+            {
+                HANDLE file{Files.Open(Name, Access, Disposition)};
+                if (file != INVALID_HANDLE_VALUE && (Flags & FILE_FLAG_OVERLAPPED))
+                {
+                    Io.Track(file);
+                }
+                return file;
+            })
+        , ReadFileGuard([&Files, &Io](HANDLE Handle, LPVOID Buffer, DWORD Size, LPDWORD Read,
+                                      LPOVERLAPPED Overlapped) -> BOOL
+            {
+                if (!FileSystem::Owns(Handle))
+                {
+                    return ReadFile_t::Real(Handle, Buffer, Size, Read, Overlapped);
+                }
+                if (!Overlapped || !Io.Tracked(Handle))
+                {
+                    return Files.Read(Handle, Buffer, Size, Read, Overlapped);
+                }
+                Io.Submit(Handle, Overlapped, Size,
+                          [&Files, Handle, Buffer, at = At(Overlapped)](DWORD Bytes, DWORD& Transferred) mutable -> DWORD
+                    {
+                        return Files.Read(Handle, Buffer, Bytes, &Transferred, &at) ? NO_ERROR : GetLastError();
+                    });
+                SetLastError(ERROR_IO_PENDING);
+                return FALSE;
+            })
+        , WriteFileGuard([&Files, &Io](HANDLE Handle, LPCVOID Buffer, DWORD Size, LPDWORD Written,
+                                       LPOVERLAPPED Overlapped) -> BOOL
+            {
+                if (!FileSystem::Owns(Handle))
+                {
+                    return WriteFile_t::Real(Handle, Buffer, Size, Written, Overlapped);
+                }
+                if (!Overlapped || !Io.Tracked(Handle))
+                {
+                    return Files.Write(Handle, Buffer, Size, Written, Overlapped);
+                }
+                Io.Submit(Handle, Overlapped, Size,
+                          [&Files, Handle, Buffer, at = At(Overlapped)](DWORD Bytes, DWORD& Transferred) mutable -> DWORD
+                    {
+                        return Files.Write(Handle, Buffer, Bytes, &Transferred, &at) ? NO_ERROR : GetLastError();
+                    });
+                SetLastError(ERROR_IO_PENDING);
+                return FALSE;
+            })
+        , CloseHandleGuard([&Files, &Io](HANDLE Handle) -> BOOL
+            {
+                if (Engine::Owns(Handle))
+                {
+                    return Io.Close(Handle);
+                }
+                if (FileSystem::Owns(Handle))
+                {
+                    Io.Release(Handle);
+                    return Files.Close(Handle);
+                }
+                return CloseHandle_t::Real(Handle);
+            })
+        , CreatePortGuard([&Io](HANDLE File, HANDLE Existing, ULONG_PTR Key, DWORD Threads) -> HANDLE
+            {
+                if (File != INVALID_HANDLE_VALUE && !Engine::Owns(Existing) && !Io.Tracked(File))
+                {
+                    return CreateIoCompletionPort_t::Real(File, Existing, Key, Threads);
+                }
+                return Io.Associate(File, Existing, Key);
+            })
+        , DequeueGuard([&Io](HANDLE Port, LPDWORD Bytes, PULONG_PTR Key,
+                             LPOVERLAPPED* Overlapped, DWORD Timeout) -> BOOL
+            {
+                return Engine::Owns(Port) ? Io.Dequeue(Port, Bytes, Key, Overlapped, Timeout) :
+                       GetQueuedCompletionStatus_t::Real(Port, Bytes, Key, Overlapped, Timeout);
+            })
+        , PostGuard([&Io](HANDLE Port, DWORD Bytes, ULONG_PTR Key, LPOVERLAPPED Overlapped) -> BOOL
+            {
+                return Engine::Owns(Port) ? Io.Post(Port, Bytes, Key, Overlapped) :
+                       PostQueuedCompletionStatus_t::Real(Port, Bytes, Key, Overlapped);
+            })
+        , ResultGuard([&Io](HANDLE File, LPOVERLAPPED Overlapped, LPDWORD Bytes, BOOL Wait) -> BOOL
+            {
+                return Io.Tracked(File) ? Io.Result(Overlapped, Bytes, Wait) :
+                       GetOverlappedResult_t::Real(File, Overlapped, Bytes, Wait);
+            })
+        , CancelGuard([&Io](HANDLE File, LPOVERLAPPED Overlapped) -> BOOL
+            {
+                return Io.Tracked(File) ? Io.Cancel(File, Overlapped) :
+                       CancelIoEx_t::Real(File, Overlapped);
+            })
+    {
+    }
+
+private:
+    //! @brief Offset of an operation, without the event signaled by the engine
+    static OVERLAPPED At(LPOVERLAPPED Overlapped)
+    {
+        OVERLAPPED at{};
+        at.Offset = Overlapped->Offset;
+        at.OffsetHigh = Overlapped->OffsetHigh;
+        return at;
+    }
+
+    typename CreateFileW_t::Guard CreateFileGuard;
+    typename ReadFile_t::Guard ReadFileGuard;
+    typename WriteFile_t::Guard WriteFileGuard;
+    typename CloseHandle_t::Guard CloseHandleGuard;
+    typename CreateIoCompletionPort_t::Guard CreatePortGuard;
+    typename GetQueuedCompletionStatus_t::Guard DequeueGuard;
+    typename PostQueuedCompletionStatus_t::Guard PostGuard;
+    typename GetOverlappedResult_t::Guard ResultGuard;
+    typename CancelIoEx_t::Guard CancelGuard;
+};
+
+} // namespace async
+} // namespace ffmock
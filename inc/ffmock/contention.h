@@ -0,0 +1,770 @@
+/**
+  @brief Lock contention profiler
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <handleapi.h>
+#include <profileapi.h>
+#include <synchapi.h>
+#include <intrin.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#pragma intrinsic(_ReturnAddress)
+
+namespace ffmock
+{
+namespace contention
+{
+
+//! @brief Locks and call sites tracked by each thread
+constexpr ULONG Entries_k = 64;
+//! @brief Buckets per power of 2 of the wait histograms
+constexpr ULONG Steps_k = 4;
+//! @brief Buckets of the wait histograms (waits up to 2^32 ticks)
+constexpr ULONG Buckets_k = 32 * Steps_k;
+//! @brief Locks held at once by a thread, for the hold times
+constexpr ULONG Holding_k = 32;
+//! @brief Frames searched for the call site
+constexpr ULONG Frames_k = 32;
+
+/**
+ * @brief Kinds of synchronization primitives
+ */
+enum class Primitive : ULONG
+{
+    CriticalSection,    //!< EnterCriticalSection()
+    Exclusive,          //!< AcquireSRWLockExclusive()
+    Shared,             //!< AcquireSRWLockShared()
+    Wait                //!< WaitForSingleObject()
+};
+
+/**
+ * @brief Contended acquisitions of a lock from one call site
+ */
+struct SiteReport
+{
+    const void* Address;    //!< Return address of the call acquiring the lock
+    ULONGLONG Contended;    //!< Acquisitions which waited
+    double WaitNs;          //!< Total wait
+};
+
+/**
+ * @brief Contention of one lock, over all threads
+ */
+struct LockReport
+{
+    const void* Address;
+    const char* Name;           //!< Set by Profiler::Name(), or nullptr
+    Primitive Kind;
+    ULONGLONG Acquired;         //!< All acquisitions
+    ULONGLONG Contended;        //!< Acquisitions which waited
+    double WaitNs;              //!< Total wait
+    double P99WaitNs;           //!< 99th percentile of the wait of all acquisitions
+    double MaxWaitNs;
+    double HoldNs;              //!< Total hold time (not measured for waits)
+    std::vector<SiteReport> Sites;  //!< Call sites of the contended acquisitions, hottest first
+};
+
+/**
+ * @brief Profiler measuring the wait and hold times of locks taken through the mocks
+ *
+ * @details Each thread records into a shard of its own, so recording takes no lock
+ *          and shares no cache line. An acquisition first tries the lock; only when
+ *          it must wait are the clock read and the call site captured. The shards
+ *          are summed into the report.
+ *          The call site is the return address of the mocked API, found by a probe
+ *          when the mocks are mounted.
+ *
+ * @note Waits for objects are tried with a zero timeout first, so a wait satisfied
+ *       at once counts as uncontended.
+ */
+class Profiler
+{
+public:
+    Profiler(void)
+        : Id(Instances.fetch_add(1, std::memory_order_relaxed) + 1)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        NsPerTick = 1e9 / double(frequency.QuadPart);
+    }
+
+    Profiler(Profiler const&) = delete;
+    Profiler& operator=(Profiler const&) = delete;
+
+    ~Profiler(void)
+    {
+        for (Shard* shard : Shards)
+        {
+            delete shard;
+        }
+    }
+
+    /*************************************************************
+     * @brief Test helpers
+     *************************************************************/
+
+    /**
+     * @brief Name a lock in the report
+     *
+     * @param Address - Address of the lock (or the waited handle)
+     * @param Label - Name of the lock (must outlive the profiler)
+     */
+    void Name(const void* Address, const char* Label)
+    {
+        std::lock_guard<std::mutex> lock(Registry);
+        Names[Address] = Label;
+    }
+
+    /**
+     * @brief Acquisitions not recorded because a thread's table was full
+     */
+    ULONGLONG Dropped(void) const
+    {
+        std::lock_guard<std::mutex> lock(Registry);
+        ULONGLONG dropped{};
+        for (Shard const* shard : Shards)
+        {
+            dropped += shard->Dropped.Get();
+        }
+        return dropped;
+    }
+
+    /**
+     * @brief Sum the shards of all threads
+     *
+     * @return std::vector<LockReport> - Locks with the longest total wait first
+     */
+    std::vector<LockReport> Report(void) const
+    {
+        std::lock_guard<std::mutex> lock(Registry);
+        std::vector<LockReport> locks;
+        std::vector<std::array<ULONGLONG, Buckets_k>> histograms;
+        std::unordered_map<const void*, size_t> index;
+        for (Shard const* shard : Shards)
+        {
+            for (Entry const& entry : shard->Entries)
+            {
+                const void* address{entry.Lock.load(std::memory_order_acquire)};
+                if (!address)
+                {
+                    continue;
+                }
+                auto found = index.emplace(address, locks.size());
+                if (found.second)
+                {
+                    auto name = Names.find(address);
+                    locks.push_back(LockReport{address, name != Names.end() ? name->second : nullptr, entry.Kind});
+                    histograms.emplace_back();
+                }
+                LockReport& report{locks[found.first->second]};
+                if (entry.Site)
+                {
+                    auto site = std::find_if(report.Sites.begin(), report.Sites.end(),
+                                             [&entry](SiteReport const& Known) { return Known.Address == entry.Site; });
+                    if (site == report.Sites.end())
+                    {
+                        site = report.Sites.insert(report.Sites.end(), SiteReport{entry.Site});
+                    }
+                    site->Contended += entry.Contended.Get();
+                    site->WaitNs += double(entry.Waited.Get()) * NsPerTick;
+                    continue;
+                }
+                report.Acquired += entry.Acquired.Get();
+                report.Contended += entry.Contended.Get();
+                report.WaitNs += double(entry.Waited.Get()) * NsPerTick;
+                report.MaxWaitNs = (std::max)(report.MaxWaitNs, double(entry.Longest.Get()) * NsPerTick);
+                report.HoldNs += double(entry.Held.Get()) * NsPerTick;
+                for (ULONG bucket = 0; bucket < Buckets_k; ++bucket)
+                {
+                    histograms[found.first->second][bucket] += entry.Buckets[bucket].Get();
+                }
+            }
+        }
+
+        for (size_t lock = 0; lock < locks.size(); ++lock)
+        {
+            LockReport& report{locks[lock]};
+            const ULONGLONG rank{(report.Acquired * 99 + 99) / 100};
+            ULONGLONG count{};
+            for (ULONG bucket = 0; bucket < Buckets_k && rank; ++bucket)
+            {
+                count += histograms[lock][bucket];
+                if (count >= rank)
+                {
+                    report.P99WaitNs = (std::min)(double(Bound(bucket)) * NsPerTick, report.MaxWaitNs);
+                    break;
+                }
+            }
+            std::sort(report.Sites.begin(), report.Sites.end(),
+                      [](SiteReport const& Left, SiteReport const& Right) { return Left.WaitNs > Right.WaitNs; });
+        }
+        std::sort(locks.begin(), locks.end(),
+                  [](LockReport const& Left, LockReport const& Right)
+                  {
+                      return Left.WaitNs != Right.WaitNs ? Left.WaitNs > Right.WaitNs : Left.Contended > Right.Contended;
+                  });
+        return locks;
+    }
+
+    /**
+     * @brief Print the hottest locks, and their hottest call sites
+     *
+     * @param Output - Stream to print to
+     * @param Top - Number of locks to print
+     */
+    void Write(FILE* Output, size_t Top = 10) const
+    {
+        static const char* Kinds[]{"critical_section", "srw_exclusive", "srw_shared", "wait"};
+        fprintf(Output, "%-24s %-16s %12s %12s %12s %12s %12s %12s\n", "lock", "kind", "acquired",
+                "contended", "wait_ms", "p99_wait_us", "max_wait_us", "hold_ms");
+        std::vector<LockReport> locks{Report()};
+        for (size_t index = 0; index < locks.size() && index < Top; ++index)
+        {
+            LockReport const& lock{locks[index]};
+            char name[32];
+            if (lock.Name)
+            {
+                snprintf(name, sizeof(name), "%s", lock.Name);
+            }
+            else
+            {
+                snprintf(name, sizeof(name), "%p", lock.Address);
+            }
+            fprintf(Output, "%-24s %-16s %12llu %12llu %12.3f %12.3f %12.3f %12.3f\n", name,
+                    Kinds[ULONG(lock.Kind)], lock.Acquired, lock.Contended, lock.WaitNs / 1e6,
+                    lock.P99WaitNs / 1e3, lock.MaxWaitNs / 1e3, lock.HoldNs / 1e6);
+            for (size_t site = 0; site < lock.Sites.size() && site < 3; ++site)
+            {
+                char module[MAX_PATH]{"?"};
+                HMODULE handle;
+                if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                                       GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                       static_cast<LPCSTR>(lock.Sites[site].Address), &handle))
+                {
+                    GetModuleFileNameA(handle, module, ARRAYSIZE(module));
+                }
+                else
+                {
+                    handle = nullptr;
+                }
+                const char* file{strrchr(module, '\\')};
+                fprintf(Output, "    at %s+0x%llx %12llu %12.3f\n", file ? file + 1 : module,
+                        ULONGLONG(static_cast<const char*>(lock.Sites[site].Address) -
+                                  reinterpret_cast<const char*>(handle)),
+                        lock.Sites[site].Contended, lock.Sites[site].WaitNs / 1e6);
+            }
+        }
+    }
+
+    /*************************************************************
+     * @brief API implementations
+     *************************************************************/
+
+    /**
+     * @brief Acquire a lock, measuring the wait
+     *
+     * @param Address - Address of the lock
+     * @param Kind - Kind of the lock
+     * @param Try - Acquire the lock if free, returning true
+     * @param Block - Acquire the lock, waiting if needed
+     */
+    template<typename Try_t, typename Block_t>
+    void Acquire(const void* Address, Primitive Kind, Try_t&& Try, Block_t&& Block)
+    {
+        Shard* shard{Local()};
+        if (!shard)
+        {
+            Block();
+            return;
+        }
+        if (shard->Probe)
+        {
+            Capture(0, Frames_k, shard->Probe);
+            shard->Probe = nullptr;
+            Block();
+            return;
+        }
+        if (Try())
+        {
+            Record(*shard, Address, nullptr, Kind, false, 0);
+        }
+        else
+        {
+            PVOID site{};
+            const ULONG skip{Skips[ULONG(Kind)].load(std::memory_order_relaxed)};
+            if (skip)
+            {
+                Capture(skip, 1, &site);
+            }
+            const ULONGLONG start{Ticks()};
+            Block();
+            Record(*shard, Address, site, Kind, true, Ticks() - start);
+        }
+        if (shard->Depth < Holding_k)
+        {
+            shard->Holding[shard->Depth++] = Hold{Address, Ticks()};
+        }
+    }
+
+    /**
+     * @brief Release a lock, measuring the time it was held
+     *
+     * @param Address - Address of the lock
+     * @param Unlock - Release the lock
+     */
+    template<typename Unlock_t>
+    void Release(const void* Address, Unlock_t&& Unlock)
+    {
+        const ULONGLONG now{Ticks()};
+        Unlock();
+        Cache const& cache{Cached()};
+        if (cache.Owner != Id)
+        {
+            return;
+        }
+        Shard& shard{*cache.Data};
+        for (ULONG index = shard.Depth; index--;)
+        {
+            if (shard.Holding[index].Lock == Address)
+            {
+                Entry* entry{Find(shard, Address, nullptr, false)};
+                if (entry)
+                {
+                    entry->Held.Add(now - shard.Holding[index].Start);
+                }
+                for (ULONG next = index + 1; next < shard.Depth; ++next)
+                {
+                    shard.Holding[next - 1] = shard.Holding[next];
+                }
+                --shard.Depth;
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Wait for an object, measuring the wait
+     *
+     * @param Handle - The object
+     * @param Timeout - Time to wait in milliseconds
+     * @param Real - The real wait
+     *
+     * @return DWORD - Result of the real wait
+     */
+    template<typename Wait_t>
+    DWORD Wait(HANDLE Handle, DWORD Timeout, Wait_t&& Real)
+    {
+        Shard* shard{Local()};
+        if (!shard)
+        {
+            return Real(Handle, Timeout);
+        }
+        if (shard->Probe)
+        {
+            Capture(0, Frames_k, shard->Probe);
+            shard->Probe = nullptr;
+            return Real(Handle, Timeout);
+        }
+        DWORD result{Real(Handle, 0)};
+        if (result == WAIT_TIMEOUT && Timeout)
+        {
+            PVOID site{};
+            const ULONG skip{Skips[ULONG(Primitive::Wait)].load(std::memory_order_relaxed)};
+            if (skip)
+            {
+                Capture(skip, 1, &site);
+            }
+            const ULONGLONG start{Ticks()};
+            result = Real(Handle, Timeout);
+            Record(*shard, Handle, site, Primitive::Wait, true, Ticks() - start);
+        }
+        else if (result != WAIT_TIMEOUT && result != WAIT_FAILED)
+        {
+            Record(*shard, Handle, nullptr, Primitive::Wait, false, 0);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Make the next acquisition of this thread capture its stack
+     *
+     * @param Frames - Receives Frames_k frames
+     */
+    bool Arm(PVOID* Frames)
+    {
+        Shard* shard{Local()};
+        if (shard)
+        {
+            shard->Probe = Frames;
+        }
+        return shard != nullptr;
+    }
+
+    /**
+     * @brief Locate the call site in the stacks of a kind of lock
+     *
+     * @param Kind - Kind of lock probed
+     * @param Frames - Stack captured by the probe
+     * @param Caller - Return address of the probe
+     */
+    void Calibrate(Primitive Kind, PVOID const* Frames, const void* Caller)
+    {
+        for (ULONG index = 1; index < Frames_k; ++index)
+        {
+            if (Frames[index] == Caller)
+            {
+                // The frame before the probe's return address is the call in the probe
+                Skips[ULONG(Kind)].store(index - 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Counter written by its thread only
+     */
+    class Counter
+    {
+    public:
+        void Add(ULONGLONG Value)
+        {
+            Total.store(Total.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+        }
+        void Max(ULONGLONG Value)
+        {
+            if (Value > Total.load(std::memory_order_relaxed))
+            {
+                Total.store(Value, std::memory_order_relaxed);
+            }
+        }
+        ULONGLONG Get(void) const
+        {
+            return Total.load(std::memory_order_relaxed);
+        }
+    private:
+        std::atomic<ULONGLONG> Total{};
+    };
+
+    /**
+     * @brief Statistics of a lock (Site is nullptr), or of a call site of a lock
+     */
+    struct Entry
+    {
+        std::atomic<const void*> Lock{};
+        const void* Site{};
+        Primitive Kind{};
+        Counter Acquired;
+        Counter Contended;
+        Counter Waited;
+        Counter Longest;
+        Counter Held;
+        Counter Buckets[Buckets_k];
+    };
+
+    struct Hold
+    {
+        const void* Lock;
+        ULONGLONG Start;
+    };
+
+    struct Shard
+    {
+        Entry Entries[Entries_k];
+        Hold Holding[Holding_k];
+        ULONG Depth{};
+        Counter Dropped;
+        PVOID* Probe{};
+    };
+
+    //! @brief Shard of the current thread
+    struct Cache
+    {
+        ULONGLONG Owner;
+        Shard* Data;
+    };
+
+    static Cache& Cached(void)
+    {
+        static thread_local Cache cache{};
+        return cache;
+    }
+
+    Shard* Local(void)
+    {
+        Cache& cache{Cached()};
+        if (cache.Owner == Id)
+        {
+            return cache.Data;
+        }
+        Shard* shard{new (std::nothrow) Shard};
+        if (!shard)
+        {
+            return nullptr;
+        }
+        try
+        {
+            std::lock_guard<std::mutex> lock(Registry);
+            Shards.push_back(shard);
+        }
+        catch (std::exception const&)
+        {
+            delete shard;
+            return nullptr;
+        }
+        cache = Cache{Id, shard};
+        return shard;
+    }
+
+    static ULONGLONG Ticks(void)
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return ULONGLONG(now.QuadPart);
+    }
+
+    __declspec(noinline)
+    static void Capture(ULONG Skip, ULONG Count, PVOID* Frames)
+    {
+        RtlCaptureStackBackTrace(Skip, Count, Frames, nullptr);
+    }
+
+    //! @brief Histogram bucket of a wait, exact below Steps_k ticks
+    static ULONG Bucket(ULONGLONG Wait)
+    {
+        static_assert(Steps_k == 4, "Two bits select the step");
+        if (Wait < Steps_k)
+        {
+            return ULONG(Wait);
+        }
+        ULONG top{};
+        for (ULONGLONG value = Wait; value >>= 1;)
+        {
+            ++top;
+        }
+        return (std::min)((top - 1) * Steps_k + ULONG((Wait >> (top - 2)) & (Steps_k - 1)), Buckets_k - 1);
+    }
+
+    //! @brief Longest wait in a bucket
+    static ULONGLONG Bound(ULONG Bucket)
+    {
+        if (Bucket < Steps_k)
+        {
+            return Bucket;
+        }
+        const ULONG top{Bucket / Steps_k + 1};
+        return ((ULONGLONG(Steps_k + Bucket % Steps_k) + 1) << (top - 2)) - 1;
+    }
+
+    //! @brief Entry of a lock, or a call site (owner thread only)
+    static Entry* Find(Shard& Owner, const void* Address, const void* Site, bool Insert, Primitive Kind = {})
+    {
+        static_assert(!(Entries_k & (Entries_k - 1)), "Entries_k must be a power of 2");
+        ULONG_PTR hash{ULONG_PTR(Address) ^ ULONG_PTR(Site)};
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6D;
+        ULONG slot{ULONG(hash >> 12) & (Entries_k - 1)};
+        for (ULONG probe = 0; probe < Entries_k; ++probe, slot = (slot + 1) % Entries_k)
+        {
+            Entry& entry{Owner.Entries[slot]};
+            const void* lock{entry.Lock.load(std::memory_order_relaxed)};
+            if (lock == Address && entry.Site == Site)
+            {
+                return &entry;
+            }
+            if (!lock)
+            {
+                if (!Insert)
+                {
+                    return nullptr;
+                }
+                entry.Site = Site;
+                entry.Kind = Kind;
+                entry.Lock.store(Address, std::memory_order_release);
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void Record(Shard& Owner, const void* Address, const void* Site, Primitive Kind, bool Waited, ULONGLONG Wait)
+    {
+        Entry* entry{Find(Owner, Address, nullptr, true, Kind)};
+        if (!entry)
+        {
+            Owner.Dropped.Add(1);
+            return;
+        }
+        entry->Acquired.Add(1);
+        entry->Buckets[Bucket(Wait)].Add(1);
+        if (!Waited)
+        {
+            return;
+        }
+        entry->Contended.Add(1);
+        entry->Waited.Add(Wait);
+        entry->Longest.Max(Wait);
+        Entry* site{Site ? Find(Owner, Address, Site, true, Kind) : nullptr};
+        if (site)
+        {
+            site->Contended.Add(1);
+            site->Waited.Add(Wait);
+        }
+    }
+
+    static inline std::atomic<ULONGLONG> Instances{};
+    const ULONGLONG Id;
+    double NsPerTick;
+    std::atomic<ULONG> Skips[4]{};
+    mutable std::mutex Registry;
+    std::vector<Shard*> Shards;
+    std::unordered_map<const void*, const char*> Names;
+};
+
+/**
+ * @brief Redirect the synchronization mocks to a contention profiler
+ *
+ * @details The locks are still taken by the real APIs.
+ *
+ * @tparam EnterCriticalSection_t - Mock class of EnterCriticalSection()
+ * @tparam LeaveCriticalSection_t - Mock class of LeaveCriticalSection()
+ * @tparam AcquireSRWLockExclusive_t - Mock class of AcquireSRWLockExclusive()
+ * @tparam ReleaseSRWLockExclusive_t - Mock class of ReleaseSRWLockExclusive()
+ * @tparam AcquireSRWLockShared_t - Mock class of AcquireSRWLockShared()
+ * @tparam ReleaseSRWLockShared_t - Mock class of ReleaseSRWLockShared()
+ * @tparam WaitForSingleObject_t - Mock class of WaitForSingleObject()
+ */
+template<typename EnterCriticalSection_t, typename LeaveCriticalSection_t,
+         typename AcquireSRWLockExclusive_t, typename ReleaseSRWLockExclusive_t,
+         typename AcquireSRWLockShared_t, typename ReleaseSRWLockShared_t,
+         typename WaitForSingleObject_t>
+class Mount
+{
+public:
+    explicit Mount(Profiler& Profile)
+        : EnterGuard([&Profile](LPCRITICAL_SECTION Section)
+            {
+                Profile.Acquire(Section, Primitive::CriticalSection,
+                                [Section] { return TryEnterCriticalSection(Section) != FALSE; },
+                                [Section] { EnterCriticalSection_t::Real(Section); });
+            })
+        , LeaveGuard([&Profile](LPCRITICAL_SECTION Section)
+            {
+                Profile.Release(Section, [Section] { LeaveCriticalSection_t::Real(Section); });
+            })
+        , ExclusiveGuard([&Profile](PSRWLOCK Lock)
+            {
+                Profile.Acquire(Lock, Primitive::Exclusive,
+                                [Lock] { return TryAcquireSRWLockExclusive(Lock) != FALSE; },
+                                [Lock] { AcquireSRWLockExclusive_t::Real(Lock); });
+            })
+        , ReleaseExclusiveGuard([&Profile](PSRWLOCK Lock)
+            {
+                Profile.Release(Lock, [Lock] { ReleaseSRWLockExclusive_t::Real(Lock); });
+            })
+        , SharedGuard([&Profile](PSRWLOCK Lock)
+            {
+                Profile.Acquire(Lock, Primitive::Shared,
+                                [Lock] { return TryAcquireSRWLockShared(Lock) != FALSE; },
+                                [Lock] { AcquireSRWLockShared_t::Real(Lock); });
+            })
+        , ReleaseSharedGuard([&Profile](PSRWLOCK Lock)
+            {
+                Profile.Release(Lock, [Lock] { ReleaseSRWLockShared_t::Real(Lock); });
+            })
+        , WaitGuard([&Profile](HANDLE Handle, DWORD Timeout) -> DWORD
+            {
+                return Profile.Wait(Handle, Timeout, [](HANDLE Object, DWORD Milliseconds)
+                    {
+                        return WaitForSingleObject_t::Real(Object, Milliseconds);
+                    });
+            })
+    {
+        Probe(Profile, Primitive::CriticalSection);
+        Probe(Profile, Primitive::Exclusive);
+        Probe(Profile, Primitive::Shared);
+        Probe(Profile, Primitive::Wait);
+    }
+
+private:
+    //! @brief Take a lock of the given kind through the mocks, locating the call site
+    __declspec(noinline)
+    static void Probe(Profiler& Profile, Primitive Kind)
+    {
+        PVOID frames[Frames_k]{};
+        if (!Profile.Arm(frames))
+        {
+            return;
+        }
+        CRITICAL_SECTION section;
+        SRWLOCK lock = SRWLOCK_INIT;
+        HANDLE event{};
+        switch (Kind)
+        {
+        case Primitive::CriticalSection:
+            InitializeCriticalSection(&section);
+            ::EnterCriticalSection(&section);
+            ::LeaveCriticalSection(&section);
+            DeleteCriticalSection(&section);
+            break;
+        case Primitive::Exclusive:
+            ::AcquireSRWLockExclusive(&lock);
+            ::ReleaseSRWLockExclusive(&lock);
+            break;
+        case Primitive::Shared:
+            ::AcquireSRWLockShared(&lock);
+            ::ReleaseSRWLockShared(&lock);
+            break;
+        case Primitive::Wait:
+            event = CreateEventW(nullptr, TRUE, TRUE, nullptr);
+            if (event)
+            {
+                ::WaitForSingleObject(event, INFINITE);
+                CloseHandle(event);
+            }
+            break;
+        }
+        Profile.Calibrate(Kind, frames, _ReturnAddress());
+    }
+
+    typename EnterCriticalSection_t::Guard EnterGuard;
+    typename LeaveCriticalSection_t::Guard LeaveGuard;
+    typename AcquireSRWLockExclusive_t::Guard ExclusiveGuard;
+    typename ReleaseSRWLockExclusive_t::Guard ReleaseExclusiveGuard;
+    typename AcquireSRWLockShared_t::Guard SharedGuard;
+    typename ReleaseSRWLockShared_t::Guard ReleaseSharedGuard;
+    typename WaitForSingleObject_t::Guard WaitGuard;
+};
+
+} // namespace contention
+} // namespace ffmock
@@ -0,0 +1,778 @@
+/**
+  @brief Cross-process mock control
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <handleapi.h>
+#include <memoryapi.h>
+#include <synchapi.h>
+#include <sysinfoapi.h>
+#include <processenv.h>
+#include <processthreadsapi.h>
+#include <threadpoolapiset.h>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+namespace ffmock
+{
+namespace control
+{
+
+//! @brief Environment variable passing the channel name to the child process
+constexpr wchar_t Environment_k[] = L"FFMOCK_CONTROL";
+//! @brief Default time to wait for the child process to handle a command
+constexpr DWORD Timeout_k = 10000;
+
+/**
+ * @brief Environment block of this process with one more variable
+ *
+ * @details Passed to CreateProcessW (with CREATE_UNICODE_ENVIRONMENT), so only
+ *          the child process sees the variable.
+ *
+ * @param[in] Name - Name of the variable (replaces any inherited value)
+ * @param[in] Value - Value of the variable
+ *
+ * @return std::wstring - The environment block
+ */
+inline std::wstring EnvironmentBlock(_In_z_ PCWSTR Name, _In_z_ PCWSTR Value)
+{
+    const std::wstring assignment{std::wstring{Name} + L'='};
+    std::wstring block;
+    if (PWCH strings = GetEnvironmentStringsW())
+    {
+        for (PCWSTR variable = strings; *variable; variable += wcslen(variable) + 1)
+        {
+            if (_wcsnicmp(variable, assignment.c_str(), assignment.size()))
+            {
+                block.append(variable).push_back(L'\0');
+            }
+        }
+        FreeEnvironmentStringsW(strings);
+    }
+    // The block ends with an empty string, the null terminator of the std::wstring
+    block.append(assignment).append(Value).push_back(L'\0');
+    return block;
+}
+
+/**
+ * @brief Operations the child process can be asked to perform on a mock
+ */
+enum class Op : LONG
+{
+    Return,     //!< Install a mock returning a canned value
+    Fault,      //!< Install a mock failing per a fault profile
+    Clear,      //!< Restore the real API
+    Calls,      //!< Query the mocked API calls count
+    ResetCalls  //!< Reset the mocked API calls count
+};
+
+/**
+ * @brief Completion status of a command
+ */
+enum class Status : LONG
+{
+    Pending,    //!< Not handled yet by the child process
+    Success,    //!< Command completed
+    NotFound,   //!< No mock with the requested name
+    Invalid,    //!< Malformed command
+    Timeout     //!< The child process did not respond in time
+};
+
+/**
+ * @brief Command sent to the child process
+ *
+ * @details Only plain data is allowed here since the command is shared between
+ *          processes.
+ */
+struct Request
+{
+    Op     Operation;   //!< Requested operation
+    char   Api[64];     //!< Name of the mocked API
+    LONG64 Value;       //!< Op::Return - value to return
+    DWORD  Error;       //!< Op::Return - last error to set
+    LONG   Skip;        //!< Op::Fault - calls passed to the real API before the first failure
+    LONG   Count;       //!< Op::Fault - number of failures (0 is unlimited)
+    LONG   Every;       //!< Op::Fault - fail every Nth call after the skipped calls
+    LONG   Calls;       //!< Op::Calls - calls count returned by the child process
+};
+
+/**
+ * @brief Shared memory layout of the command ring
+ *
+ * @details Single producer (the test process) and single consumer (the child
+ *          process). The section is zero initialized by the OS.
+ */
+struct Ring
+{
+    //! @brief Commands the test process can post before waiting for completion
+    static constexpr LONG Slots_k = 64;
+
+    /**
+     * @brief Ring entry
+     */
+    struct Slot
+    {
+        std::atomic<LONG> State;    //!< Status of the command
+        Request           Body;     //!< Command and its reply
+    };
+
+    std::atomic<LONG> Attached;     //!< Set by the server owning the consumer side
+    std::atomic<LONG> Head;         //!< Next slot to post
+    std::atomic<LONG> Tail;         //!< Next slot to handle
+    Slot              Slots[Slots_k];
+};
+
+static_assert(std::atomic<LONG>::is_always_lock_free, "Shared atomics must be lock free");
+
+/**
+ * @brief Named shared memory section and wakeup events of the command ring
+ */
+class Channel
+{
+public:
+    Channel(void) = default;
+    Channel(Channel const&) = delete;
+    Channel& operator=(Channel const&) = delete;
+
+    /**
+     * @brief Destroy the Channel object releasing the section and events
+     */
+    ~Channel(void)
+    {
+        if (View)
+        {
+            UnmapViewOfFile(View);
+        }
+        for (HANDLE handle : {Section, RequestEvent, ReplyEvent})
+        {
+            if (handle)
+            {
+                CloseHandle(handle);
+            }
+        }
+    }
+
+    /**
+     * @brief Create new channel (test process side)
+     *
+     * @param[in] ChannelName - Base name of the kernel objects
+     *
+     * @return true if successful
+     */
+    bool Create(_In_z_ PCWSTR ChannelName)
+    {
+        Name = ChannelName;
+        Section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                     0, sizeof(Ring), Name.c_str());
+        RequestEvent = CreateEventW(nullptr, FALSE, FALSE, (Name + L".request").c_str());
+        ReplyEvent = CreateEventW(nullptr, FALSE, FALSE, (Name + L".reply").c_str());
+        return Map();
+    }
+
+    /**
+     * @brief Open existing channel (child process side)
+     *
+     * @param[in] ChannelName - Base name of the kernel objects
+     *
+     * @return true if successful
+     */
+    bool Open(_In_z_ PCWSTR ChannelName)
+    {
+        Name = ChannelName;
+        Section = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, Name.c_str());
+        RequestEvent = OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, (Name + L".request").c_str());
+        ReplyEvent = OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, (Name + L".reply").c_str());
+        return Map();
+    }
+
+    explicit operator bool(void) const
+    {
+        return View != nullptr;
+    }
+
+    Ring* operator->(void) const
+    {
+        return View;
+    }
+
+    //! @brief Base name of the kernel objects
+    std::wstring Name;
+    //! @brief Signaled by the test process when commands are posted
+    HANDLE RequestEvent{};
+    //! @brief Signaled by the child process when commands complete
+    HANDLE ReplyEvent{};
+
+private:
+    bool Map(void)
+    {
+        if (!Section || !RequestEvent || !ReplyEvent)
+        {
+            return false;
+        }
+        View = static_cast<Ring*>(MapViewOfFile(Section, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Ring)));
+        return View != nullptr;
+    }
+
+    HANDLE Section{};
+    Ring*  View{};
+};
+
+/**
+ * @brief Named mock which can be controlled by the test process
+ *
+ * @details Endpoints register at static initialization of the binary hosting the
+ *          mocks (see DEFINE_CONTROL) and are looked up by the server by name.
+ */
+class Endpoint
+{
+public:
+    Endpoint(Endpoint const&) = delete;
+    Endpoint& operator=(Endpoint const&) = delete;
+
+    /**
+     * @brief Find registered endpoint
+     *
+     * @param[in] Api - Name of the mocked API
+     *
+     * @return Endpoint* - The endpoint or nullptr if not found
+     */
+    static Endpoint* Find(_In_z_ const char* Api)
+    {
+        for (Endpoint* endpoint = Endpoints(); endpoint; endpoint = endpoint->Next)
+        {
+            if (!strcmp(endpoint->Name, Api))
+            {
+                return endpoint;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Handle command sent by the test process
+     *
+     * @param[in,out] Body - The command (and its reply data)
+     *
+     * @return Status - Completion status of the command
+     */
+    virtual Status Dispatch(_Inout_ Request& Body) = 0;
+
+protected:
+    Endpoint(_In_z_ const char* Api)
+        : Name(Api)
+        , Next(Endpoints())
+    {
+        Endpoints() = this;
+    }
+
+    ~Endpoint(void) = default;
+
+private:
+    static Endpoint*& Endpoints(void)
+    {
+        static Endpoint* endpoints{};
+        return endpoints;
+    }
+
+    const char* Name;
+    Endpoint*   Next;
+};
+
+/**
+ * @brief Endpoint installing and clearing Guard behaviors of a mock
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ */
+template<typename Mock_t>
+class MockEndpoint
+    : public Endpoint
+{
+    using Ret_t = typename Mock_t::Ret_t;
+    using Api_t = typename Mock_t::Api_t;
+
+    /**
+     * @brief Shared state of an installed fault profile
+     */
+    struct Fault
+    {
+        LONG Skip;
+        LONG Count;
+        LONG Every;
+        std::atomic<LONG> Calls;
+    };
+
+public:
+    MockEndpoint(_In_z_ const char* Api)
+        : Endpoint(Api)
+    {
+    }
+
+    Status Dispatch(_Inout_ Request& Body) override
+    {
+        switch (Body.Operation)
+        {
+            case Op::Return:
+                Install(Returning(Cast(Body.Value), Body.Error));
+                return Status::Success;
+
+            case Op::Fault:
+                if (Body.Skip < 0 || Body.Count < 0 || Body.Every < 1)
+                {
+                    return Status::Invalid;
+                }
+                Install(Failing(Body.Skip, Body.Count, Body.Every));
+                return Status::Success;
+
+            case Op::Clear:
+                Guard.reset();
+                return Status::Success;
+
+            case Op::Calls:
+                Body.Calls = Mock_t::CallCount();
+                return Status::Success;
+
+            case Op::ResetCalls:
+                Mock_t::ResetCallCount();
+                return Status::Success;
+
+            default:
+                return Status::Invalid;
+        }
+    }
+
+private:
+    static Ret_t Cast(LONG64 Value)
+    {
+        if constexpr (std::is_pointer_v<Ret_t>)
+        {
+            return reinterpret_cast<Ret_t>(static_cast<ULONG_PTR>(Value));
+        }
+        else
+        {
+            return static_cast<Ret_t>(Value);
+        }
+    }
+
+    static Ret_t Fail(void)
+    {
+        if constexpr (Mock_t::Error2Set_k != NO_ERROR)
+        {
+            SetLastError(Mock_t::Error2Set_k);
+        }
+        return Mock_t::ErrorValue();
+    }
+
+    static Api_t Returning(Ret_t Value, DWORD Error)
+    {
+        return [Value, Error](auto...) -> Ret_t
+               {
+                   if (Error)
+                   {
+                       SetLastError(Error);
+                   }
+                   return Value;
+               };
+    }
+
+    static Api_t Failing(LONG Skip, LONG Count, LONG Every)
+    {
+        std::shared_ptr<Fault> fault{new Fault{Skip, Count, Every, {}}};
+        return [fault](auto... Args) -> Ret_t
+               {
+                   LONG call{fault->Calls.fetch_add(1, std::memory_order_relaxed)};
+                   if (call >= fault->Skip)
+                   {
+                       call -= fault->Skip;
+                       if (!(call % fault->Every) &&
+                           (!fault->Count || call / fault->Every < fault->Count))
+                       {
+                           return Fail();
+                       }
+                   }
+                   return Mock_t::Real(Args...);
+               };
+    }
+
+    /**
+     * @brief Set the mock of the Guard
+     *
+     * @details The Guard publishes the mock atomically, and waits for the calls of
+     *          the child's threads running the replaced mock (and its Fault) to
+     *          return before freeing it.
+     */
+    void Install(Api_t&& MockImpl)
+    {
+        if (Guard)
+        {
+            Guard->Set(MockImpl);
+        }
+        else
+        {
+            Guard.emplace(std::move(MockImpl));
+        }
+    }
+
+    //! @brief Guard kept alive between commands
+    std::optional<typename Mock_t::Guard> Guard;
+};
+
+/**
+ * @brief Consumer side of the command ring in the child process
+ *
+ * @details The server attaches to the channel named by the FFMOCK_CONTROL
+ *          environment variable. When the variable is not set the server is idle.
+ *          Commands are handled on a thread pool wait, so no thread is dedicated
+ *          to the channel.
+ *
+ * @warning The server must be instantiated in the same binary as the mocks and
+ *          their endpoints (see DEFINE_CONTROL).
+ */
+class Server
+{
+public:
+    /**
+     * @brief Construct the Server object and attach to the test process channel
+     */
+    Server(void)
+    {
+        wchar_t name[MAX_PATH];
+        DWORD length{GetEnvironmentVariableW(Environment_k, name, _countof(name))};
+        if (!length || length >= _countof(name) || !Channel.Open(name))
+        {
+            return;
+        }
+        LONG detached{};
+        if (!Channel->Attached.compare_exchange_strong(detached, 1))
+        {
+            // Another copy of the mocks already serves this channel
+            return;
+        }
+        Wait = CreateThreadpoolWait(&Server::Callback, this, nullptr);
+        if (Wait)
+        {
+            SetThreadpoolWait(Wait, Channel.RequestEvent, nullptr);
+        }
+    }
+
+    Server(Server const&) = delete;
+    Server& operator=(Server const&) = delete;
+
+    /**
+     * @brief Destroy the Server object stopping handling of commands
+     */
+    ~Server(void)
+    {
+        if (Wait)
+        {
+            // A callback running before Stopping was set may arm the wait again
+            Stopping.store(true, std::memory_order_release);
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                SetThreadpoolWait(Wait, nullptr, nullptr);
+                WaitForThreadpoolWaitCallbacks(Wait, TRUE);
+            }
+            CloseThreadpoolWait(Wait);
+        }
+    }
+
+    /**
+     * @brief Check if this process was spawned by a Controller
+     *
+     * @return true if the process is controlled by a test process
+     */
+    static bool Hosted(void)
+    {
+        return GetEnvironmentVariableW(Environment_k, nullptr, 0) != 0;
+    }
+
+private:
+    static void CALLBACK Callback(PTP_CALLBACK_INSTANCE, PVOID Context, PTP_WAIT Wait, TP_WAIT_RESULT)
+    {
+        Server* server{static_cast<Server*>(Context)};
+        server->Drain();
+        if (!server->Stopping.load(std::memory_order_acquire))
+        {
+            SetThreadpoolWait(Wait, server->Channel.RequestEvent, nullptr);
+        }
+    }
+
+    void Drain(void)
+    {
+        LONG tail{Channel->Tail.load(std::memory_order_relaxed)};
+        while (tail != Channel->Head.load(std::memory_order_acquire))
+        {
+            Ring::Slot& slot{Channel->Slots[tail % Ring::Slots_k]};
+            slot.Body.Api[_countof(slot.Body.Api) - 1] = '\0';
+            Endpoint* endpoint{Endpoint::Find(slot.Body.Api)};
+            Status status{endpoint ? endpoint->Dispatch(slot.Body) : Status::NotFound};
+            slot.State.store(static_cast<LONG>(status), std::memory_order_release);
+            Channel->Tail.store(++tail, std::memory_order_release);
+            SetEvent(Channel.ReplyEvent);
+        }
+    }
+
+    control::Channel Channel;
+    PTP_WAIT Wait{};
+    //! @brief Set by the destructor, so callbacks don't arm the wait again
+    std::atomic<bool> Stopping{false};
+};
+
+/**
+ * @brief Producer side of the command ring in the test process
+ *
+ * @details Create one controller per child process. The controller is not
+ *          thread safe; commands should be sent from a single test thread.
+ * @example
+ * @code {.cpp}
+ * ffmock::control::Controller controller;
+ * HANDLE child = controller.Spawn(L"service.exe --console");
+ * controller.Return("RegOpenKeyW", ERROR_ACCESS_DENIED);
+ * controller.Fault("RegSetValueExW", 2, 1); // Fail the third call
+ * LONG calls = controller.Calls("RegCloseKey");
+ * @endcode
+ */
+class Controller
+{
+public:
+    /**
+     * @brief Construct the Controller object creating uniquely named channel
+     */
+    Controller(void)
+    {
+        static std::atomic<LONG> instances;
+        std::wstring name{L"Local\\ffmock.control."};
+        name += std::to_wstring(GetCurrentProcessId()) + L"." +
+                std::to_wstring(instances.fetch_add(1));
+        Channel.Create(name.c_str());
+    }
+
+    Controller(Controller const&) = delete;
+    Controller& operator=(Controller const&) = delete;
+
+    explicit operator bool(void) const
+    {
+        return static_cast<bool>(Channel);
+    }
+
+    /**
+     * @brief Start child process connected to this controller
+     *
+     * @param[in] CommandLine - Command line of the child process
+     *
+     * @return HANDLE - Child process handle (close by the caller) or nullptr
+     */
+    HANDLE Spawn(_In_z_ PCWSTR CommandLine)
+    {
+        std::wstring commandLine{CommandLine};
+        std::wstring environment{EnvironmentBlock(Environment_k, Channel.Name.c_str())};
+        STARTUPINFOW startup{sizeof(startup)};
+        PROCESS_INFORMATION process{};
+
+        if (!CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, FALSE,
+                            CREATE_UNICODE_ENVIRONMENT, environment.data(), nullptr,
+                            &startup, &process))
+        {
+            return nullptr;
+        }
+        CloseHandle(process.hThread);
+        return process.hProcess;
+    }
+
+    /**
+     * @brief Make the mocked API return a canned value
+     *
+     * @param[in] Api - Name of the mocked API
+     * @param[in] Value - Value to return
+     * @param[in] Error - Last error to set (optional)
+     *
+     * @return Status - Completion status of the command
+     */
+    Status Return(_In_z_ const char* Api, LONG64 Value, DWORD Error = NO_ERROR)
+    {
+        Request body{};
+        body.Operation = Op::Return;
+        body.Value = Value;
+        body.Error = Error;
+        return Call(Api, body);
+    }
+
+    /**
+     * @brief Make the mocked API fail per a fault profile
+     *
+     * @details Failing calls return the mock's RetValue and set its Error2Set. All
+     *          other calls pass through to the real API.
+     *
+     * @param[in] Api - Name of the mocked API
+     * @param[in] Skip - Calls to pass through before the first failure
+     * @param[in] Count - Number of failures (0 is unlimited)
+     * @param[in] Every - Fail every Nth call after the skipped calls
+     *
+     * @return Status - Completion status of the command
+     */
+    Status Fault(_In_z_ const char* Api, LONG Skip, LONG Count = 0, LONG Every = 1)
+    {
+        Request body{};
+        body.Operation = Op::Fault;
+        body.Skip = Skip;
+        body.Count = Count;
+        body.Every = Every;
+        return Call(Api, body);
+    }
+
+    /**
+     * @brief Restore the real API
+     *
+     * @param[in] Api - Name of the mocked API
+     *
+     * @return Status - Completion status of the command
+     */
+    Status Clear(_In_z_ const char* Api)
+    {
+        Request body{};
+        body.Operation = Op::Clear;
+        return Call(Api, body);
+    }
+
+    /**
+     * @brief Query the mocked API calls count
+     *
+     * @param[in] Api - Name of the mocked API
+     *
+     * @return LONG - Calls count, or -1 if the command failed
+     */
+    LONG Calls(_In_z_ const char* Api)
+    {
+        Request body{};
+        body.Operation = Op::Calls;
+        return Call(Api, body) == Status::Success ? body.Calls : -1;
+    }
+
+    /**
+     * @brief Reset the mocked API calls count
+     *
+     * @param[in] Api - Name of the mocked API
+     *
+     * @return Status - Completion status of the command
+     */
+    Status ResetCalls(_In_z_ const char* Api)
+    {
+        Request body{};
+        body.Operation = Op::ResetCalls;
+        return Call(Api, body);
+    }
+
+    /**
+     * @brief Post command without waiting for its completion
+     *
+     * @param[in] Body - The command
+     * @param[in] Timeout - Time to wait for a free slot (milliseconds)
+     *
+     * @return LONG - Ticket to wait on, or -1 if the ring stayed full
+     */
+    LONG Post(_In_ Request const& Body, DWORD Timeout = Timeout_k)
+    {
+        LONG head{Channel->Head.load(std::memory_order_relaxed)};
+        while (head - Channel->Tail.load(std::memory_order_acquire) >= Ring::Slots_k)
+        {
+            if (WaitForSingleObject(Channel.ReplyEvent, Timeout) != WAIT_OBJECT_0)
+            {
+                return -1;
+            }
+        }
+        Ring::Slot& slot{Channel->Slots[head % Ring::Slots_k]};
+        slot.Body = Body;
+        slot.State.store(static_cast<LONG>(Status::Pending), std::memory_order_relaxed);
+        Channel->Head.store(head + 1, std::memory_order_release);
+        SetEvent(Channel.RequestEvent);
+        return head;
+    }
+
+    /**
+     * @brief Wait for completion of a posted command
+     *
+     * @param[in] Ticket - Value returned by Post()
+     * @param[out] Reply - Command with the reply data
+     * @param[in] Timeout - Time to wait (milliseconds)
+     *
+     * @return Status - Completion status of the command
+     */
+    Status Wait(LONG Ticket, _Out_ Request& Reply, DWORD Timeout = Timeout_k)
+    {
+        if (Ticket < 0)
+        {
+            return Status::Timeout;
+        }
+        Ring::Slot& slot{Channel->Slots[Ticket % Ring::Slots_k]};
+        const ULONGLONG deadline{GetTickCount64() + Timeout};
+        Status status;
+        while ((status = static_cast<Status>(slot.State.load(std::memory_order_acquire))) == Status::Pending)
+        {
+            const ULONGLONG now{GetTickCount64()};
+            if (now >= deadline ||
+                WaitForSingleObject(Channel.ReplyEvent, static_cast<DWORD>(deadline - now)) != WAIT_OBJECT_0)
+            {
+                return Status::Timeout;
+            }
+        }
+        Reply = slot.Body;
+        return status;
+    }
+
+private:
+    Status Call(_In_z_ const char* Api, _Inout_ Request& Body)
+    {
+        strncpy_s(Body.Api, Api, _TRUNCATE);
+        return Wait(Post(Body), Body);
+    }
+
+    control::Channel Channel;
+};
+
+} // namespace control
+} // namespace ffmock
+
+
+/**
+ * @brief Register mock for control by the test process
+ *
+ * @param NAME_SPACE - Optional namespace of the mocked class
+ * @param API_NAME - The API being mocked
+ *
+ * @warning Like DEFINE_GUARD, the endpoint must be defined in the same binary as
+ *          the mocks and before the ffmock::control::Server instance.
+ * @example
+ * @code {.cpp}
+ * DEFINE_CONTROL(Mocks, RegOpenKeyW);
+ *
+ * static ffmock::control::Server ControlServer;
+ * @endcode
+ */
+#define DEFINE_CONTROL(NAME_SPACE, API_NAME)                                \
+static ::ffmock::control::MockEndpoint<NAME_SPACE::FF##API_NAME>            \
+    FFControl##API_NAME{#API_NAME}
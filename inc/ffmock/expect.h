@@ -0,0 +1,682 @@
+/**
+  @brief Expectations on mocked APIs
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ffmock
+{
+namespace expect
+{
+
+//! @brief Upper bound of expectations without a maximum number of calls
+constexpr ULONG Unbounded_k = ~ULONG(0);
+
+/*************************************************************
+ * @brief Argument matchers
+ *
+ * @details Matchers are literal types, composed at compile time. A value given
+ *          instead of a matcher is compared for equality.
+ *************************************************************/
+
+/**
+ * @brief Match any argument
+ */
+struct Anything
+{
+    static constexpr bool Matcher_k = true;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const&) const
+    {
+        return true;
+    }
+};
+
+//! @brief Match any argument
+inline constexpr Anything _{};
+
+/**
+ * @brief Match the argument compared with a value, converted to the argument's type
+ *
+ * @tparam Value_t - Type of the compared value
+ * @tparam Compare_t - Comparison (e.g., std::equal_to<>)
+ */
+template<typename Value_t, typename Compare_t>
+struct Compares
+{
+    static constexpr bool Matcher_k = true;
+
+    Value_t Value;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return Compare_t{}(Arg, static_cast<Arg_t>(Value));
+    }
+};
+
+/**
+ * @brief Match a null or a non null pointer
+ */
+template<bool Null_k>
+struct Nullness
+{
+    static constexpr bool Matcher_k = true;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return (Arg == nullptr) == Null_k;
+    }
+};
+
+/**
+ * @brief Match a string equal to the value (both may be null)
+ *
+ * @tparam Char_t - Character type (char or wchar_t)
+ */
+template<typename Char_t>
+struct StringEquals
+{
+    static constexpr bool Matcher_k = true;
+
+    const Char_t* Value;
+
+    constexpr bool operator()(const Char_t* Arg) const
+    {
+        if (!Arg || !Value)
+        {
+            return Arg == Value;
+        }
+        const Char_t* expected{Value};
+        while (*Arg && *Arg == *expected)
+        {
+            ++Arg;
+            ++expected;
+        }
+        return *Arg == *expected;
+    }
+};
+
+/**
+ * @brief Match a non null pointer, whose pointee matches
+ */
+template<typename Matcher_t>
+struct Pointee
+{
+    static constexpr bool Matcher_k = true;
+
+    Matcher_t Inner;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return Arg != nullptr && Inner(*Arg);
+    }
+};
+
+/**
+ * @brief Match an argument for which a predicate returns true
+ */
+template<typename Predicate_t>
+struct Satisfies
+{
+    static constexpr bool Matcher_k = true;
+
+    Predicate_t Predicate;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return static_cast<bool>(Predicate(Arg));
+    }
+};
+
+/**
+ * @brief Match an argument matched by all, or by any, of the matchers
+ */
+template<bool All_k, typename... Matchers_t>
+struct Combines
+{
+    static constexpr bool Matcher_k = true;
+
+    std::tuple<Matchers_t...> Inner;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return Match(Arg, std::index_sequence_for<Matchers_t...>{});
+    }
+
+private:
+    template<typename Arg_t, size_t... Index_k>
+    constexpr bool Match(Arg_t const& Arg, std::index_sequence<Index_k...>) const
+    {
+        if constexpr (All_k)
+        {
+            return (std::get<Index_k>(Inner)(Arg) && ...);
+        }
+        else
+        {
+            return (std::get<Index_k>(Inner)(Arg) || ...);
+        }
+    }
+};
+
+/**
+ * @brief Match an argument not matched by the matcher
+ */
+template<typename Matcher_t>
+struct Negates
+{
+    static constexpr bool Matcher_k = true;
+
+    Matcher_t Inner;
+
+    template<typename Arg_t>
+    constexpr bool operator()(Arg_t const& Arg) const
+    {
+        return !Inner(Arg);
+    }
+};
+
+/**
+ * @brief Matcher of an expected argument (matchers are used as is, values compared)
+ */
+template<typename Arg_t, typename = void>
+struct AsMatcher
+{
+    using type = Compares<Arg_t, std::equal_to<>>;
+
+    static constexpr type Make(Arg_t Value)
+    {
+        return type{Value};
+    }
+};
+
+template<typename Arg_t>
+struct AsMatcher<Arg_t, std::enable_if_t<Arg_t::Matcher_k>>
+{
+    using type = Arg_t;
+
+    static constexpr type Make(Arg_t Matcher)
+    {
+        return Matcher;
+    }
+};
+
+template<typename Value_t>
+constexpr Compares<Value_t, std::equal_to<>> Eq(Value_t Value) { return {Value}; }
+template<typename Value_t>
+constexpr Compares<Value_t, std::not_equal_to<>> Ne(Value_t Value) { return {Value}; }
+template<typename Value_t>
+constexpr Compares<Value_t, std::less<>> Lt(Value_t Value) { return {Value}; }
+template<typename Value_t>
+constexpr Compares<Value_t, std::less_equal<>> Le(Value_t Value) { return {Value}; }
+template<typename Value_t>
+constexpr Compares<Value_t, std::greater<>> Gt(Value_t Value) { return {Value}; }
+template<typename Value_t>
+constexpr Compares<Value_t, std::greater_equal<>> Ge(Value_t Value) { return {Value}; }
+constexpr Nullness<true> IsNull(void) { return {}; }
+constexpr Nullness<false> NotNull(void) { return {}; }
+template<typename Char_t>
+constexpr StringEquals<Char_t> StrEq(const Char_t* Value) { return {Value}; }
+template<typename Inner_t>
+constexpr Pointee<typename AsMatcher<Inner_t>::type> Points(Inner_t Inner) { return {AsMatcher<Inner_t>::Make(Inner)}; }
+template<typename Predicate_t>
+constexpr Satisfies<Predicate_t> Truly(Predicate_t Predicate) { return {Predicate}; }
+template<typename... Inner_t>
+constexpr Combines<true, typename AsMatcher<Inner_t>::type...> AllOf(Inner_t... Inner) { return {{AsMatcher<Inner_t>::Make(Inner)...}}; }
+template<typename... Inner_t>
+constexpr Combines<false, typename AsMatcher<Inner_t>::type...> AnyOf(Inner_t... Inner) { return {{AsMatcher<Inner_t>::Make(Inner)...}}; }
+template<typename Inner_t>
+constexpr Negates<typename AsMatcher<Inner_t>::type> Not(Inner_t Inner) { return {AsMatcher<Inner_t>::Make(Inner)}; }
+
+/*************************************************************
+ * @brief Actions taken by matched calls
+ *************************************************************/
+
+/**
+ * @brief Fail like the mock's default Guard (RetValue and Error2Set)
+ */
+struct Fails
+{
+    template<typename Mock_t, typename... Args_t>
+    typename Mock_t::Ret_t Act(Args_t&...) const
+    {
+        if constexpr (Mock_t::Error2Set_k != NO_ERROR)
+        {
+            SetLastError(Mock_t::Error2Set_k);
+        }
+        return Mock_t::ErrorValue();
+    }
+};
+
+/**
+ * @brief Return a value, optionally setting the last error
+ */
+template<typename Value_t>
+struct Returns
+{
+    Value_t Value;
+    DWORD Error;
+
+    template<typename Mock_t, typename... Args_t>
+    typename Mock_t::Ret_t Act(Args_t&...) const
+    {
+        if (Error)
+        {
+            SetLastError(Error);
+        }
+        return static_cast<typename Mock_t::Ret_t>(Value);
+    }
+};
+
+/**
+ * @brief Call a function with the API arguments (e.g., to write out parameters)
+ */
+template<typename Body_t>
+struct Invokes
+{
+    Body_t Body;
+
+    template<typename Mock_t, typename... Args_t>
+    typename Mock_t::Ret_t Act(Args_t&... Args) const
+    {
+        return Body(Args...);
+    }
+};
+
+/**
+ * @brief Pass the call to the real API
+ */
+struct Forwards
+{
+    template<typename Mock_t, typename... Args_t>
+    typename Mock_t::Ret_t Act(Args_t&... Args) const
+    {
+        return Mock_t::Real(Args...);
+    }
+};
+
+/*************************************************************
+ * @brief Expectations
+ *************************************************************/
+
+/**
+ * @brief Calls which must match their expectations in order, across mocks
+ *
+ * @details An expectation in a sequence only matches once all the expectations
+ *          before it are satisfied. Expectations before the last one matched
+ *          are retired. The expectations are kept in fixed storage.
+ *
+ * @note Declare the sequence before the expectations in it.
+ *       The order is meant to be checked for calls from a single thread.
+ */
+class Sequence
+{
+public:
+    //! @brief Maximum number of expectations in a sequence
+    static constexpr ULONG Capacity_k = 64;
+
+    Sequence(void) = default;
+    Sequence(Sequence const&) = delete;
+    Sequence& operator=(Sequence const&) = delete;
+
+    /**
+     * @brief Add an expectation at the end of the sequence
+     *
+     * @param Calls - Calls count of the expectation
+     * @param Least - Minimal count of calls satisfying the expectation
+     *
+     * @return ULONG - Position of the expectation
+     */
+    ULONG Add(std::atomic<ULONG> const& Calls, ULONG Least)
+    {
+        _ASSERT(Size < Capacity_k);
+        if (Size == Capacity_k)
+        {
+            // Never matches
+            return Capacity_k;
+        }
+        Slots[Size] = Slot{&Calls, Least};
+        return Size++;
+    }
+
+    /**
+     * @brief Check the expectations before a position are satisfied, and retire them
+     *
+     * @param Position - Position of the matched expectation
+     *
+     * @return true if the expectation may match
+     */
+    bool Enter(ULONG Position)
+    {
+        ULONG cursor{Cursor.load(std::memory_order_acquire)};
+        for (;;)
+        {
+            if (Position < cursor || Position >= Size)
+            {
+                return false;
+            }
+            for (ULONG before = cursor; before < Position; ++before)
+            {
+                if (Slots[before].Calls->load(std::memory_order_acquire) < Slots[before].Least)
+                {
+                    return false;
+                }
+            }
+            if (Cursor.compare_exchange_weak(cursor, Position, std::memory_order_acq_rel))
+            {
+                return true;
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<ULONG> const* Calls;
+        ULONG Least;
+    };
+
+    std::array<Slot, Capacity_k> Slots{};
+    ULONG Size{};
+    std::atomic<ULONG> Cursor{};
+};
+
+/**
+ * @brief Expected call: argument matchers, cardinality, sequence and action
+ *
+ * @details Built by Call(), then refined. Each refinement returns a new expectation.
+ *
+ * @tparam Matchers_t - Tuple of a matcher per API argument
+ * @tparam Action_t - Action of the matched calls
+ */
+template<typename Matchers_t, typename Action_t>
+struct Expectation
+{
+    Matchers_t Matchers;
+    Action_t Action;
+    ULONG Min;              //!< Calls required to satisfy the expectation
+    ULONG Max;              //!< Calls matched at most (then the next expectation is tried)
+    Sequence* Order;        //!< Sequence of the expectation (optional)
+
+    constexpr Expectation Times(ULONG Count) const
+    {
+        return Expectation{Matchers, Action, Count, Count, Order};
+    }
+
+    constexpr Expectation Times(ULONG Least, ULONG Most) const
+    {
+        return Expectation{Matchers, Action, Least, Most, Order};
+    }
+
+    constexpr Expectation AtLeast(ULONG Count) const
+    {
+        return Expectation{Matchers, Action, Count, Unbounded_k, Order};
+    }
+
+    constexpr Expectation AtMost(ULONG Count) const
+    {
+        return Expectation{Matchers, Action, 0, Count, Order};
+    }
+
+    constexpr Expectation InSequence(Sequence& Ordered) const
+    {
+        return Expectation{Matchers, Action, Min, Max, &Ordered};
+    }
+
+    template<typename Value_t>
+    constexpr Expectation<Matchers_t, Returns<Value_t>> Return(Value_t Value, DWORD Error = NO_ERROR) const
+    {
+        return {Matchers, Returns<Value_t>{Value, Error}, Min, Max, Order};
+    }
+
+    template<typename Body_t>
+    constexpr Expectation<Matchers_t, Invokes<Body_t>> Invoke(Body_t Body) const
+    {
+        return {Matchers, Invokes<Body_t>{Body}, Min, Max, Order};
+    }
+
+    constexpr Expectation<Matchers_t, Forwards> Real(void) const
+    {
+        return {Matchers, Forwards{}, Min, Max, Order};
+    }
+
+    /**
+     * @brief Check if the arguments match
+     */
+    template<typename... Args_t>
+    constexpr bool Matches(Args_t const&... Args) const
+    {
+        static_assert(sizeof...(Args_t) == std::tuple_size_v<Matchers_t>, "Expected one matcher per API argument");
+        return Match(std::index_sequence_for<Args_t...>{}, Args...);
+    }
+
+private:
+    template<size_t... Index_k, typename... Args_t>
+    constexpr bool Match(std::index_sequence<Index_k...>, Args_t const&... Args) const
+    {
+        return (std::get<Index_k>(Matchers)(Args) && ...);
+    }
+};
+
+/**
+ * @brief Expect a call, once, failing like the mock's default Guard
+ *
+ * @param Args - A matcher, or a value compared for equality, per API argument
+ */
+template<typename... Args_t>
+constexpr Expectation<std::tuple<typename AsMatcher<Args_t>::type...>, Fails> Call(Args_t... Args)
+{
+    return {std::tuple<typename AsMatcher<Args_t>::type...>{AsMatcher<Args_t>::Make(Args)...},
+            Fails{}, 1, 1, nullptr};
+}
+
+/**
+ * @brief Mock behavior matching each call against a fixed set of expectations
+ *
+ * @details The expectations are tried in the order they were declared. A call
+ *          matches the first expectation whose matchers accept the arguments, which
+ *          did not reach its maximum calls, and whose sequence allows it. The
+ *          expectations are members of a tuple, so matching a call is straight-line
+ *          code, and the calls counts are in fixed storage: matching neither locks
+ *          nor allocates. A call matching no expectation is unexpected, and fails
+ *          like the mock's default Guard.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ * @tparam Expectations_t - Expectation types
+ * @example
+ * @code {.cpp}
+ * using namespace ffmock::expect;
+ * auto expected = Expect<Mocks::FFRegOpenKeyW>(
+ *     Call(HKEY_LOCAL_MACHINE, StrEq(L"Software"), NotNull()).Times(2).Return(ERROR_SUCCESS),
+ *     Call(_, _, _).AtMost(1).Return(ERROR_ACCESS_DENIED));
+ * Mocks::FFRegOpenKeyW::Guard guard(std::ref(expected));
+ * ...
+ * EXPECT_TRUE(expected.Verify());
+ * @endcode
+ */
+template<typename Mock_t, typename... Expectations_t>
+class Expectations
+{
+    using Ret_t = typename Mock_t::Ret_t;
+
+public:
+    //! @brief Number of expectations
+    static constexpr size_t Count_k = sizeof...(Expectations_t);
+
+    explicit Expectations(Expectations_t const&... Items)
+        : List(Items...)
+    {
+        Enlist(std::index_sequence_for<Expectations_t...>{});
+    }
+
+    Expectations(Expectations const&) = delete;
+    Expectations& operator=(Expectations const&) = delete;
+
+    /**
+     * @brief Number of calls matched by an expectation
+     *
+     * @param Index - Index of the expectation, in declaration order
+     */
+    ULONG Calls(size_t Index) const
+    {
+        return Counts[Index].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Check if an expectation had its minimal number of calls
+     *
+     * @param Index - Index of the expectation, in declaration order
+     */
+    bool Satisfied(size_t Index) const
+    {
+        return Calls(Index) >= Least[Index];
+    }
+
+    /**
+     * @brief Number of calls which matched no expectation
+     */
+    ULONG Unexpected(void) const
+    {
+        return Stray.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Check all expectations are satisfied, and no call was unexpected
+     */
+    bool Verify(void) const
+    {
+        for (size_t index = 0; index < Count_k; ++index)
+        {
+            if (!Satisfied(index))
+            {
+                return false;
+            }
+        }
+        return !Unexpected();
+    }
+
+    /**
+     * @brief Mock implementation matching the call
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Value of the matched expectation's action
+     */
+    template<typename... Args_t>
+    Ret_t operator()(Args_t... Args)
+    {
+        return Dispatch<0>(Args...);
+    }
+
+private:
+    template<size_t... Index_k>
+    void Enlist(std::index_sequence<Index_k...>)
+    {
+        (Enlist(std::get<Index_k>(List), Index_k), ...);
+    }
+
+    template<typename Expectation_t>
+    void Enlist(Expectation_t const& Item, size_t Index)
+    {
+        Least[Index] = Item.Min;
+        if (Item.Order)
+        {
+            Positions[Index] = Item.Order->Add(Counts[Index], Item.Min);
+        }
+    }
+
+    template<size_t Index_k, typename... Args_t>
+    Ret_t Dispatch(Args_t&... Args)
+    {
+        if constexpr (Index_k == Count_k)
+        {
+            Stray.fetch_add(1, std::memory_order_acq_rel);
+            return Fails{}.template Act<Mock_t>(Args...);
+        }
+        else
+        {
+            auto const& item{std::get<Index_k>(List)};
+            if (item.Matches(Args...) && Take(Index_k, item))
+            {
+                return item.Action.template Act<Mock_t>(Args...);
+            }
+            return Dispatch<Index_k + 1>(Args...);
+        }
+    }
+
+    //! @brief Count a matched call, unless the expectation is saturated or out of order
+    template<typename Expectation_t>
+    bool Take(size_t Index, Expectation_t const& Item)
+    {
+        std::atomic<ULONG>& calls{Counts[Index]};
+        ULONG count{calls.load(std::memory_order_acquire)};
+        if (count >= Item.Max || (Item.Order && !Item.Order->Enter(Positions[Index])))
+        {
+            return false;
+        }
+        while (!calls.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel))
+        {
+            if (count >= Item.Max)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::tuple<Expectations_t...> List;
+    std::array<std::atomic<ULONG>, Count_k> Counts{};
+    std::array<ULONG, Count_k> Least{};
+    std::array<ULONG, Count_k> Positions{};
+    std::atomic<ULONG> Stray{};
+};
+
+/**
+ * @brief Expectations of a mock
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ *
+ * @param Items - Expectations built by Call()
+ */
+template<typename Mock_t, typename... Expectations_t>
+Expectations<Mock_t, Expectations_t...> Expect(Expectations_t const&... Items)
+{
+    return Expectations<Mock_t, Expectations_t...>(Items...);
+}
+
+} // namespace expect
+} // namespace ffmock
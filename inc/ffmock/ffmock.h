@@ -24,14 +24,47 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 #include <minwindef.h>
 #include <winerror.h>
 #include <libloaderapi.h>
+#include <processthreadsapi.h>
 
 namespace ffmock
 {
 
+/**
+ * @brief Convert the value returned by a failing mock to the API return type
+ *
+ * @details Integral values are converted to pointer return types, e.g., -1 to
+ *          INVALID_HANDLE_VALUE (see Failure).
+ *
+ * @tparam Ret_t - API return type
+ * @tparam Error_t - Type of the failure value
+ *
+ * @param Error - The failure value
+ * @return Ret_t - The failure value as returned by the API
+ */
+template<typename Ret_t, typename Error_t>
+Ret_t FailureCast(Error_t Error)
+{
+    if constexpr (std::is_pointer_v<Ret_t> && std::is_integral_v<Error_t>)
+    {
+        return reinterpret_cast<Ret_t>(Error);
+    }
+    else
+    {
+        return static_cast<Ret_t>(Error);
+    }
+}
+
 /**
  * @brief Primary template
  */
@@ -55,6 +88,8 @@ struct function_traits<RetType_t __stdcall(Args_t...)>
     using Ptr_t = Ret_t(__stdcall*)(Args_t...);
     //! @brief Functor declaration for the API
     using Api_t = std::function<Sig_t>;
+    //! @brief Free function (API) arguments
+    using Tuple_t = std::tuple<Args_t...>;
 
 #pragma warning(push)
 #pragma warning(disable:4127) // conditional expression is constant
@@ -66,9 +101,9 @@ struct function_traits<RetType_t __stdcall(Args_t...)>
      * @tparam Error_k - The value to return indicating an error
      * @tparam Error2Set_k - Set this value as the last error
      *
-     * @return Ret_t - Always Error_k
+     * @return Ret_t - Always Error_k (nothing for APIs returning void)
      */
-    template<Ret_t Error_k, DWORD Error2Set_k>
+    template<auto Error_k, DWORD Error2Set_k>
     __declspec(noinline)
     static
     Ret_t AlwaysError(Args_t...)
@@ -77,7 +112,7 @@ struct function_traits<RetType_t __stdcall(Args_t...)>
         {
             SetLastError(Error2Set_k);
         }
-        return Error_k;
+        return FailureCast<Ret_t>(Error_k);
     }
 #pragma warning(pop)
 };
@@ -100,6 +135,8 @@ struct function_traits<RetType_t __cdecl(Args_t...)>
     using Ptr_t = Ret_t(__stdcall*)(Args_t...);
     //! @brief Functor declaration for the API
     using Api_t = std::function<Sig_t>;
+    //! @brief Free function (API) arguments
+    using Tuple_t = std::tuple<Args_t...>;
 
 #pragma warning(push)
 #pragma warning(disable:4127) // conditional expression is constant
@@ -111,9 +148,9 @@ struct function_traits<RetType_t __cdecl(Args_t...)>
      * @tparam Error_k - The value to return indicating an error
      * @tparam Error2Set_k - Set this value as the last error
      *
-     * @return Ret_t - Always Error_k
+     * @return Ret_t - Always Error_k (nothing for APIs returning void)
      */
-    template<Ret_t Error_k, DWORD Error2Set_k>
+    template<auto Error_k, DWORD Error2Set_k>
     __declspec(noinline)
     static
     Ret_t AlwaysError(Args_t...)
@@ -122,12 +159,240 @@ struct function_traits<RetType_t __cdecl(Args_t...)>
         {
             SetLastError(Error2Set_k);
         }
-        return Error_k;
+        return FailureCast<Ret_t>(Error_k);
     }
 #pragma warning(pop)
 };
 #endif // !defined(WIN64)
 
+/**
+ * @brief Identity of a mocked API
+ *
+ * @details FNV-1a hash of the API name. Keeps mocks of APIs sharing the same
+ *          signature, return value and last error as distinct template instances.
+ *
+ * @param Name - Name of the mocked API
+ *
+ * @return ULONGLONG - Unique identity of the API
+ */
+constexpr ULONGLONG Identity(const char* Name)
+{
+    ULONGLONG hash{14695981039346656037ull};
+    while (*Name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*Name++)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Type of the value returned by the default failing mock
+ *
+ * @details APIs returning void have no failure value. A placeholder type keeps
+ *          the value a valid template argument.
+ *          APIs returning HANDLE fail with either nullptr or INVALID_HANDLE_VALUE.
+ *          A pointer template argument can only be nullptr, so their failure value
+ *          is given as an integer: 0 for nullptr, -1 for INVALID_HANDLE_VALUE.
+ *          Other pointer types (e.g., HKEY) only fail with nullptr.
+ */
+template<typename Ret_t>
+struct Failure
+{
+    using type = Ret_t;
+};
+
+template<>
+struct Failure<void>
+{
+    using type = int;
+};
+
+template<>
+struct Failure<HANDLE>
+{
+    using type = LONG_PTR;
+};
+
+template<typename Ret_t>
+using Failure_t = typename Failure<Ret_t>::type;
+
+/**
+ * @brief Record of a mock in the global mock registry
+ */
+struct MockEntry
+{
+    //! @brief Name of the mocked API
+    const char* Name;
+    //! @brief Number of calls made to the mocked API
+    LONG (*CallCount)(void);
+    //! @brief Check if a Guard set the mock in the current generation
+    bool (*Active)(void);
+    //! @brief Restore the real API
+    void (*Reset)(void);
+    //! @brief Save the mock state returning a functor restoring it
+    std::function<void(void)> (*Capture)(void);
+};
+
+/**
+ * @brief Global table of all mocks hosted by the mocks binary
+ *
+ * @details Mocks register at static initialization (see DEFINE_MOCK). A Guard only
+ *          applies in the generation it was set in, so bumping the generation resets
+ *          all mocks to their real API at once without visiting them.
+ *
+ * @warning The table is defined by DEFINE_MOCK_REGISTRY, which must be placed in the
+ *          same binary as the mocks.
+ * @example
+ * @code {.cpp}
+ * // Clear any Guard left behind by the previous test
+ * ffmock::MockRegistry::ResetAll();
+ *
+ * // Save all mocks, and restore them after the test
+ * ffmock::MockRegistry::Snapshot saved{ffmock::MockRegistry::Save()};
+ * ...
+ * ffmock::MockRegistry::Restore(saved);
+ * @endcode
+ */
+class MockRegistry
+{
+public:
+    //! @brief Maximum number of mocks in the table
+    static constexpr LONG Capacity_k = 8192;
+
+    /**
+     * @brief Diagnostics information of a mock
+     */
+    struct Info
+    {
+        const char* Name;   //!< Name of the mocked API
+        LONG Calls;         //!< Number of calls made to the mocked API
+        bool Active;        //!< True if the mock replaces the real API
+    };
+
+    //! @brief Saved state of all mocks
+    using Snapshot = std::vector<std::function<void(void)>>;
+
+    //! @brief Function called before each call to a mocked API, with the API identity
+    using Hook_t = void(*)(ULONGLONG ApiId);
+
+    /**
+     * @brief Add mock to the table
+     *
+     * @param[in] Entry - The mock's record (must outlive the table)
+     */
+    static void Register(MockEntry const* Entry)
+    {
+        const LONG index{Count.fetch_add(1, std::memory_order_relaxed)};
+        _ASSERT(index < Capacity_k);
+        if (index < Capacity_k)
+        {
+            Entries[index] = Entry;
+        }
+    }
+
+    /**
+     * @brief Number of registered mocks
+     */
+    static LONG Size(void)
+    {
+        const LONG count{Count.load(std::memory_order_relaxed)};
+        return count < Capacity_k ? count : Capacity_k;
+    }
+
+    /**
+     * @brief Current generation of Guards
+     */
+    static LONG Generation(void)
+    {
+        return Current.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Restore the real API for all mocks in O(1)
+     */
+    static void ResetAll(void)
+    {
+        Current.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Save the state of all mocks
+     *
+     * @return Snapshot - Saved state to pass to Restore()
+     */
+    static Snapshot Save(void)
+    {
+        Snapshot saved;
+        saved.reserve(Size());
+        for (LONG index = 0; index < Size(); ++index)
+        {
+            saved.emplace_back(Entries[index]->Capture());
+        }
+        return saved;
+    }
+
+    /**
+     * @brief Restore the state of all mocks
+     *
+     * @param[in] Saved - State returned by Save()
+     */
+    static void Restore(Snapshot const& Saved)
+    {
+        for (auto const& restore : Saved)
+        {
+            restore();
+        }
+    }
+
+    /**
+     * @brief Set the function called before each call to a mocked API
+     *
+     * @details Calls passed to the real API are hooked too. The hook must not
+     *          call mocked APIs of its own.
+     *
+     * @param[in] Callback - The hook (nullptr removes it)
+     */
+    static void SetCallHook(Hook_t Callback)
+    {
+        Hooked.store(Callback, std::memory_order_release);
+    }
+
+    /**
+     * @brief Function called before each call to a mocked API (nullptr if none)
+     */
+    static Hook_t CallHook(void)
+    {
+        return Hooked.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Enumerate all mocks
+     *
+     * @tparam Callback_t - Callable accepting Info const&
+     *
+     * @param[in] Callback - Called for each registered mock
+     */
+    template<typename Callback_t>
+    static void Enumerate(Callback_t&& Callback)
+    {
+        for (LONG index = 0; index < Size(); ++index)
+        {
+            MockEntry const& entry{*Entries[index]};
+            Callback(Info{entry.Name, entry.CallCount(), entry.Active()});
+        }
+    }
+
+private:
+    FFMOCK_IMPORT
+    static MockEntry const* Entries[Capacity_k];
+    FFMOCK_IMPORT
+    static std::atomic<LONG> Count;
+    FFMOCK_IMPORT
+    static std::atomic<LONG> Current;
+    FFMOCK_IMPORT
+    static std::atomic<Hook_t> Hooked;
+};
+
 /**
  * @brief Template implementing the basic mocking functionality for Win32 APIs
  *
@@ -135,12 +400,14 @@ struct function_traits<RetType_t __cdecl(Args_t...)>
  * @tparam API_t - API signature type
  * @tparam RetValue - Error value to return as generic failure
  * @tparam Error2Set - Value to set as last error (optional)
+ * @tparam ApiId - Identity of the API (see Identity())
  */
-template<typename RetType_t, typename API_t, RetType_t RetValue, DWORD Error2Set = NO_ERROR>
+template<typename RetType_t, typename API_t, RetType_t RetValue, DWORD Error2Set = NO_ERROR,
+         ULONGLONG ApiId = 0>
 class
 Mock
 {
-protected:
+public:
 
     //! @brief API traits specialization
     using Traits_t = function_traits<API_t>;
@@ -152,14 +419,234 @@ protected:
     using Ptr_t = typename Traits_t::Ptr_t;
     //! @brief Functor declaration for the API
     using Api_t = typename Traits_t::Api_t;
+    //! @brief Free function (API) arguments
+    using Tuple_t = typename Traits_t::Tuple_t;
     //! @brief Type declaration for this template
     using Mock_t = Mock;
 
+    //! @brief Value returned by the default failing mock
+    static constexpr RetType_t Error_k = RetValue;
+    //! @brief Last error set by the default failing mock
+    static constexpr DWORD Error2Set_k = Error2Set;
+    //! @brief Identity of the mocked API
+    static constexpr ULONGLONG Id_k = ApiId;
+
+    /**
+     * @brief Value returned by the default failing mock, as the API return type
+     */
+    static Ret_t ErrorValue(void)
+    {
+        return FailureCast<Ret_t>(Error_k);
+    }
+
+    /**
+     * @brief Number of calls made to the mocked API
+     *
+     * @return LONG - Calls count since start or the last reset
+     */
+    static LONG CallCount(void)
+    {
+        LONG calls{};
+        for (Shard_t const& shard : State.Calls)
+        {
+            calls += shard.Calls.load(std::memory_order_relaxed);
+        }
+        return calls;
+    }
+
+    /**
+     * @brief Reset the calls count of the mocked API
+     */
+    static void ResetCallCount(void)
+    {
+        StoreCallCount(0);
+    }
+
+    /**
+     * @brief Call the real API bypassing any installed mock
+     *
+     * @details Used by mock implementations which need pass-through behavior. The
+     *          real API is resolved on the first call to the mocked API.
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Return value of the real API
+     */
+    template<typename... Args_t>
+    static Ret_t Real(Args_t&&... Args)
+    {
+        return State.RealAPI(std::forward<Args_t>(Args)...);
+    }
+
+    /**
+     * @brief Check if a Guard set the mock in the current generation
+     *
+     * @return true if the mock replaces the real API
+     */
+    static bool Active(void)
+    {
+        return State.Armed.load(std::memory_order_acquire) == MockRegistry::Generation();
+    }
+
+    /**
+     * @brief Restore the real API
+     *
+     * @warning Waits for the calls running the mock to return, so it must not be
+     *          called from within the mock.
+     */
+    static void Reset(void)
+    {
+        Publish(nullptr, 0);
+    }
+
+    /**
+     * @brief Save the mock state
+     *
+     * @return std::function<void(void)> - Functor restoring the saved state
+     */
+    static std::function<void(void)> Capture(void)
+    {
+        Api_t mockAPI;
+        {
+            std::lock_guard<std::mutex> lock{State.Publishing};
+            Api_t const* active{State.MockAPI.load()};
+            if (active && Active())
+            {
+                mockAPI = *active;
+            }
+        }
+        return [mockAPI, calls = CallCount()]
+               {
+                   StoreCallCount(calls);
+                   if (mockAPI)
+                   {
+                       Publish(new Api_t(mockAPI), MockRegistry::Generation());
+                   }
+                   else
+                   {
+                       Reset();
+                   }
+               };
+    }
+
+protected:
+
+    //! @brief Number of calls count shards
+    static constexpr ULONG Shards_k = 16;
+
+    /**
+     * @brief Calls count of the threads mapped to a shard
+     *
+     * @details Padded to a cache line, so threads calling the API concurrently
+     *          don't contend on the same counter.
+     */
+    struct Shard_t
+    {
+        std::atomic<LONG> Calls;
+        char Padding[64 - sizeof(std::atomic<LONG>)];
+    };
+
+    /**
+     * @brief State of the mock
+     *
+     * @details Kept in a single static member, so each mock needs one explicit
+     *          specialization and one exported symbol.
+     */
+    struct State_t
+    {
+        //! @brief The real API
+        Api_t RealAPI;
+        //! @brief Mock implementation set by a Guard (nullptr for the real API)
+        std::atomic<Api_t const*> MockAPI;
+        //! @brief Number of calls made to the mocked API, by thread shard
+        Shard_t Calls[Shards_k];
+        //! @brief Generation in which a Guard set MockAPI
+        std::atomic<LONG> Armed;
+        //! @brief Parity of the Running counter taken by new calls
+        std::atomic<LONG> Epoch;
+        //! @brief Number of calls running MockAPI, by Epoch parity
+        std::atomic<LONG> Running[2];
+        //! @brief Serialize the Guards replacing MockAPI
+        std::mutex Publishing;
+    };
+
     FFMOCK_IMPORT
-    static Api_t RealAPI;
-    FFMOCK_IMPORT
-    static Api_t MockAPI;
-    static constexpr Ret_t Error_k = RetValue;
+    static State_t State;
+
+    /**
+     * @brief Set the calls count (not atomic with concurrent calls)
+     */
+    static void StoreCallCount(LONG Calls)
+    {
+        for (Shard_t& shard : State.Calls)
+        {
+            shard.Calls.store(&shard == State.Calls ? Calls : 0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Scope of a call running MockAPI
+     *
+     * @details Counted by the parity of the epoch it started in, so Publish() only
+     *          waits for the calls which may still run the replaced MockAPI.
+     */
+    class Caller
+    {
+    public:
+        Caller(void)
+            : Parity{State.Epoch.load() & 1}
+        {
+            State.Running[Parity].fetch_add(1);
+        }
+
+        ~Caller(void)
+        {
+            State.Running[Parity].fetch_sub(1, std::memory_order_release);
+        }
+
+        Caller(Caller const&) = delete;
+        Caller& operator=(Caller const&) = delete;
+
+    private:
+        const LONG Parity;
+    };
+
+    /**
+     * @brief Replace MockAPI, and free the replaced one once no call runs it
+     *
+     * @details The epoch is flipped twice, so a call which read the parity before
+     *          the first flip, but was counted after the wait, is waited for too.
+     *
+     * @param[in] MockImpl - New mock implementation owned by the mock (nullptr for
+     *                       the real API)
+     * @param[in] Generation - Generation in which MockImpl applies (0 for none)
+     * @param[in] Owner - Only replace MockAPI if it was set in this generation (0 to
+     *                    always replace it)
+     */
+    static void Publish(Api_t const* MockImpl, LONG Generation, LONG Owner = 0)
+    {
+        std::unique_ptr<Api_t const> replaced{MockImpl};
+        std::lock_guard<std::mutex> lock{State.Publishing};
+        if (Owner && State.Armed.load() != Owner)
+        {
+            return;
+        }
+        replaced.reset(State.MockAPI.exchange(replaced.release()));
+        State.Armed.store(Generation);
+        if (!replaced)
+        {
+            return;
+        }
+        for (int flip = 0; flip < 2; ++flip)
+        {
+            const LONG parity{State.Epoch.fetch_add(1) & 1};
+            while (State.Running[parity].load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
 
     /**
      * @brief Construct a new Mock object capturing the pointer to the real API call
@@ -169,12 +656,8 @@ protected:
      */
     Mock(HMODULE Module, const char* ApiName)
     {
-        RealAPI = Ptr_t(GetProcAddress(Module, ApiName));
-        _ASSERT(RealAPI);
-        if (!MockAPI)
-        {
-            MockAPI = RealAPI;
-        }
+        State.RealAPI = Ptr_t(GetProcAddress(Module, ApiName));
+        _ASSERT(State.RealAPI);
     }
 
     /**
@@ -188,7 +671,22 @@ protected:
     template<typename... Args_t>
     Ret_t operator()(Args_t&... Args)
     {
-        return MockAPI(Args...);
+        State.Calls[(GetCurrentThreadId() >> 2) % Shards_k].Calls.fetch_add(1, std::memory_order_relaxed);
+        if (const MockRegistry::Hook_t hook{MockRegistry::CallHook()})
+        {
+            hook(ApiId);
+        }
+        if (!Active())
+        {
+            return State.RealAPI(Args...);
+        }
+        const Caller caller;
+        Api_t const* mockAPI{State.MockAPI.load()};
+        if (!mockAPI)
+        {
+            return State.RealAPI(Args...);
+        }
+        return (*mockAPI)(Args...);
     }
 
 public:
@@ -227,6 +725,9 @@ public:
 
         /**
          * @brief Destroy the Guard object and restore the real API
+         *
+         * @details Waits for the calls running the mock to return. The real API is
+         *          not restored if a Guard set in a later generation owns the mock.
          */
         FFMOCK_IMPORT                                                                                   \
         ~Guard(void);
@@ -241,15 +742,72 @@ public:
 
         /**
          * @brief Clear the Guard object and restore the real API
+         *
+         * @warning Must not be called from within the mock, see the destructor above.
          */
         FFMOCK_IMPORT                                                                                   \
         void Clear(void);
+
+    private:
+        //! @brief Generation in which the Guard set the mock
+        LONG Generation{0};
     };
 };
 
+/**
+ * @brief Add a mock to the global mock registry at static initialization
+ *
+ * @tparam Mock_t - Mock template specialization
+ */
+template<typename Mock_t>
+class MockRegistration
+{
+public:
+    MockRegistration(const char* Name)
+        : Entry{Name, &Mock_t::CallCount, &Mock_t::Active, &Mock_t::Reset, &Mock_t::Capture}
+    {
+        MockRegistry::Register(&Entry);
+    }
+
+    MockRegistration(MockRegistration const&) = delete;
+    MockRegistration& operator=(MockRegistration const&) = delete;
+
+private:
+    MockEntry Entry;
+};
+
 } // namespace ffmock
 
 
+/**
+ * @brief Mock template specialization of a Win32 API
+ *
+ * @param API_NAME - The API being mocked
+ * @param RET_TYPE - Return type of the API
+ * @param RET_ERROR - Default value to return when the API fails (0 for void)
+ * @param LAST_ERROR - Last error code set when the API fails
+ */
+#define MOCK_TYPE(API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)                            \
+MOCK_TYPE_NAMED(API_NAME, #API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)
+
+/**
+ * @brief Mock template specialization of a Win32 API with the API name as a literal
+ *
+ * @details Macros forwarding their API_NAME argument must stringize it themselves.
+ *          The forwarded argument is macro expanded, so a mangled API (e.g.,
+ *          CreateFileW=__mock_CreateFileW) would otherwise be identified by its
+ *          mangled name.
+ *
+ * @param API_NAME - The API being mocked
+ * @param API_STRING - Name of the API as a string literal
+ * @param RET_TYPE - Return type of the API
+ * @param RET_ERROR - Default value to return when the API fails (0 for void)
+ * @param LAST_ERROR - Last error code set when the API fails
+ */
+#define MOCK_TYPE_NAMED(API_NAME, API_STRING, RET_TYPE, RET_ERROR, LAST_ERROR)          \
+::ffmock::Mock<::ffmock::Failure_t<RET_TYPE>, decltype(::API_NAME),                     \
+               RET_ERROR, LAST_ERROR, ::ffmock::Identity(API_STRING)>
+
 /**
  * @brief Declaration of mocked Win32 API
  *
@@ -264,7 +822,7 @@ public:
  */
 #define DECLARE_MOCK(API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR, CALL_TYPE, CALL_ARGS)   \
 class FF##API_NAME                                                                      \
-    : public ::ffmock::Mock<RET_TYPE, decltype(::API_NAME), RET_ERROR, LAST_ERROR>      \
+    : public MOCK_TYPE_NAMED(API_NAME, #API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)      \
 {                                                                                       \
     friend                                                                              \
     FFMOCK_IMPORT                                                                       \
@@ -277,6 +835,9 @@ class FF##API_NAME
 /**
  * @brief Instances of the mock's static members
  *
+ * @details The State declarator is parenthesized, so the leading :: of the mock
+ *          type is not parsed as part of State_t.
+ *
  * @param API_NAME - The API being mocked
  * @param RET_TYPE - Return type of the API
  * @param RET_ERROR - Default value to return when the API fails
@@ -287,12 +848,26 @@ class FF##API_NAME
 #define DEFINE_MOCK(API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)                          \
 template<>                                                                              \
 FFMOCK_IMPORT                                                                           \
-typename ::ffmock::Mock<RET_TYPE, decltype(::API_NAME), RET_ERROR, LAST_ERROR>::Api_t   \
-    ffmock::Mock<RET_TYPE, decltype(::API_NAME), RET_ERROR, LAST_ERROR>::RealAPI;       \
-template<>                                                                              \
+typename MOCK_TYPE_NAMED(API_NAME, #API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)::State_t \
+    (MOCK_TYPE_NAMED(API_NAME, #API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)::State){};   \
+static ::ffmock::MockRegistration<                                                      \
+    MOCK_TYPE_NAMED(API_NAME, #API_NAME, RET_TYPE, RET_ERROR, LAST_ERROR)>              \
+    FFRegistration##API_NAME{#API_NAME}
+
+/**
+ * @brief Instance of the global mock registry
+ *
+ * @warning Must be placed once in the binary hosting the mocks.
+ */
+#define DEFINE_MOCK_REGISTRY()                                                          \
+FFMOCK_IMPORT                                                                           \
+::ffmock::MockEntry const* ffmock::MockRegistry::Entries[ffmock::MockRegistry::Capacity_k]; \
+FFMOCK_IMPORT                                                                           \
+std::atomic<LONG> ffmock::MockRegistry::Count{0};                                       \
+FFMOCK_IMPORT                                                                           \
+std::atomic<LONG> ffmock::MockRegistry::Current{1};                                     \
 FFMOCK_IMPORT                                                                           \
-typename ::ffmock::Mock<RET_TYPE, decltype(::API_NAME), RET_ERROR, LAST_ERROR>::Api_t   \
-    ffmock::Mock<RET_TYPE, decltype(::API_NAME), RET_ERROR, LAST_ERROR>::MockAPI
+std::atomic<ffmock::MockRegistry::Hook_t> ffmock::MockRegistry::Hooked{nullptr}
 
 /**
  * @brief Instances of the mock's Guard members
@@ -344,11 +919,12 @@ FFMOCK_IMPORT                                                       \
 void NAME_SPACE::FF##API_NAME::Guard::Set(const Api_t& MockImpl)    \
 {                                                                   \
     _ASSERT(MockImpl);                                              \
-    MockAPI = MockImpl;                                             \
+    Generation = ::ffmock::MockRegistry::Generation();              \
+    Publish(new Api_t(MockImpl), Generation);                       \
 }                                                                   \
 template <>                                                         \
 FFMOCK_IMPORT                                                       \
 void NAME_SPACE::FF##API_NAME::Guard::Clear(void)                   \
 {                                                                   \
-    MockAPI = RealAPI;                                              \
+    Publish(nullptr, 0, Generation);                                \
 }
@@ -0,0 +1,238 @@
+/**
+  @brief Mock results decided by fuzzer input
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+namespace ffmock
+{
+namespace fuzz
+{
+
+/**
+ * @brief Bytes of a single fuzzer input, consumed by the mocked calls
+ *
+ * @details Reset() points to the next input without allocating, so one instance is
+ *          shared by the mocks for the whole fuzzing session. Once the input is
+ *          exhausted, reads return zeros.
+ *
+ * @note Not thread safe. The calls of an iteration are expected on a single thread.
+ */
+class Input
+{
+public:
+    Input(void) = default;
+
+    Input(const BYTE* Data, size_t Size)
+        : Next(Data)
+        , Left(Size)
+    {
+    }
+
+    Input(Input const&) = delete;
+    Input& operator=(Input const&) = delete;
+
+    /**
+     * @brief Start consuming another input
+     *
+     * @param Data - Input bytes (must outlive the iteration)
+     * @param Size - Count of input bytes
+     */
+    void Reset(const BYTE* Data, size_t Size)
+    {
+        Next = Data;
+        Left = Size;
+    }
+
+    /**
+     * @brief Count of bytes not consumed yet
+     */
+    size_t Remaining(void) const
+    {
+        return Left;
+    }
+
+    /**
+     * @brief Copy the next bytes, padding with zeros once the input is exhausted
+     *
+     * @param Buffer - Receives the bytes
+     * @param Size - Count of bytes to copy
+     */
+    void Fill(void* Buffer, size_t Size)
+    {
+        const size_t count{Size < Left ? Size : Left};
+        memcpy(Buffer, Next, count);
+        memset(static_cast<BYTE*>(Buffer) + count, 0, Size - count);
+        Next += count;
+        Left -= count;
+    }
+
+    /**
+     * @brief Read a value from the next bytes
+     *
+     * @tparam Value_t - Trivially copyable type
+     */
+    template<typename Value_t>
+    Value_t Take(void)
+    {
+        static_assert(std::is_trivially_copyable_v<Value_t>, "Values are copied from the input bytes");
+        Value_t value{};
+        Fill(&value, sizeof(value));
+        return value;
+    }
+
+private:
+    const BYTE* Next{};
+    size_t Left{};
+};
+
+/**
+ * @brief Function writing the out parameters of a call from the input
+ */
+template<typename Tuple_t>
+struct Filler;
+
+template<typename... Args_t>
+struct Filler<std::tuple<Args_t...>>
+{
+    using Ptr_t = void(*)(Input&, Args_t...);
+};
+
+/**
+ * @brief One of the results a fuzzed mock can choose for a call
+ *
+ * @details Outcomes are literal types, so the set of an API can be declared at
+ *          compile time. Captureless lambdas convert to the Out function pointer.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegSetValueExW)
+ */
+template<typename Mock_t>
+struct Outcome
+{
+    using Value_t = Failure_t<typename Mock_t::Ret_t>;
+    using Out_t = typename Filler<typename Mock_t::Tuple_t>::Ptr_t;
+
+    Value_t Value{};        //!< Value returned by the API
+    DWORD Error{NO_ERROR};  //!< Last error to set (as Error2Set)
+    Out_t Out{};            //!< Writes the out parameters from the input (optional)
+    bool Forward{};         //!< Pass the call to the real API
+
+    /**
+     * @brief Outcome passing the call to the real API
+     */
+    static constexpr Outcome Real(void)
+    {
+        return Outcome{Value_t{}, NO_ERROR, nullptr, true};
+    }
+
+    /**
+     * @brief Outcome of the mock's default failure (RetValue and Error2Set)
+     */
+    static constexpr Outcome Failure(void)
+    {
+        return Outcome{Mock_t::Error_k, Mock_t::Error2Set_k, nullptr, false};
+    }
+};
+
+/**
+ * @brief Mock behavior letting the fuzzer input decide the result of each call
+ *
+ * @details Each call consumes one byte choosing among the declared outcomes, then
+ *          the bytes its outcome's Out function reads. The first outcome is chosen
+ *          once the input is exhausted, so it is usually the success path.
+ *          Deciding neither locks nor allocates, so the Guard is set once for the
+ *          whole session, and only the Input is reset between iterations.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegSetValueExW)
+ * @tparam Outcomes_k - Number of outcomes (up to 256)
+ * @example
+ * @code {.cpp}
+ * using Outcome = ffmock::fuzz::Outcome<Mocks::FFRegSetValueExW>;
+ * static constexpr std::array<Outcome, 3> outcomes{{
+ *     {ERROR_SUCCESS}, Outcome::Failure(), {ERROR_ACCESS_DENIED}}};
+ *
+ * static ffmock::fuzz::Input input;
+ * static ffmock::fuzz::Decider decider(input, outcomes);
+ * static Mocks::FFRegSetValueExW::Guard guard(std::ref(decider));
+ * @endcode
+ */
+template<typename Mock_t, size_t Outcomes_k>
+class Decider
+{
+    using Ret_t = typename Mock_t::Ret_t;
+
+public:
+    using Outcome_t = Outcome<Mock_t>;
+
+    Decider(Input& Source, std::array<Outcome_t, Outcomes_k> const& Choices)
+        : Bytes(Source)
+        , Outcomes(Choices)
+    {
+        static_assert(Outcomes_k > 0 && Outcomes_k <= 256, "A byte chooses among 1 to 256 outcomes");
+    }
+
+    Decider(Decider const&) = delete;
+    Decider& operator=(Decider const&) = delete;
+
+    /**
+     * @brief Mock implementation taking the outcome chosen by the input
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Value of the outcome
+     */
+    template<typename... Args_t>
+    Ret_t operator()(Args_t... Args)
+    {
+        Outcome_t const& outcome{Outcomes[Bytes.Take<BYTE>() % Outcomes_k]};
+        if (outcome.Forward)
+        {
+            return Mock_t::Real(Args...);
+        }
+        if (outcome.Out)
+        {
+            outcome.Out(Bytes, Args...);
+        }
+        if (outcome.Error)
+        {
+            SetLastError(outcome.Error);
+        }
+        return FailureCast<Ret_t>(outcome.Value);
+    }
+
+private:
+    Input& Bytes;
+    const std::array<Outcome_t, Outcomes_k> Outcomes;
+};
+
+template<typename Mock_t, size_t Outcomes_k>
+Decider(Input&, std::array<Outcome<Mock_t>, Outcomes_k> const&) -> Decider<Mock_t, Outcomes_k>;
+
+} // namespace fuzz
+} // namespace ffmock
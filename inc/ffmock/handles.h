@@ -0,0 +1,89 @@
+/**
+  @brief Fake handles returned by mocks
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <minwindef.h>
+#include <winnt.h>
+
+namespace ffmock
+{
+namespace handles
+{
+
+/**
+ * @brief Kinds of objects behind fake handles
+ */
+enum class Kind : ULONG
+{
+    File = 1,   //!< In-memory file (see memfs.h)
+    Port = 2,   //!< Simulated I/O completion port (see async.h)
+    Socket = 3  //!< In-memory socket (see sockets.h)
+};
+
+//! @brief Low bits of all fake handles (kernel handles are multiples of 4)
+constexpr ULONG_PTR Tag_k = 0x3;
+//! @brief Mask of the low bits, including the reserved bits 2-3
+constexpr ULONG_PTR TagMask_k = 0xF;
+//! @brief Position of the kind in the handle
+constexpr ULONG_PTR KindShift_k = 4;
+//! @brief Position of the slot in the handle
+constexpr ULONG_PTR SlotShift_k = 8;
+//! @brief Fake handles are below this value, excluding pseudo handles (e.g., -1)
+constexpr ULONG_PTR Limit_k = ULONG_PTR(1) << 28;
+
+/**
+ * @brief Make a fake handle
+ *
+ * @param Type - Kind of the object
+ * @param Slot - Index of the object in the owner's table
+ *
+ * @return HANDLE - Handle which never collides with a kernel handle
+ */
+inline HANDLE Make(Kind Type, ULONG Slot)
+{
+    return reinterpret_cast<HANDLE>((ULONG_PTR(Slot) << SlotShift_k) |
+                                    (ULONG_PTR(Type) << KindShift_k) | Tag_k);
+}
+
+/**
+ * @brief Check if the handle is a fake handle of the given kind
+ */
+inline bool Is(HANDLE Handle, Kind Type)
+{
+    const ULONG_PTR value{reinterpret_cast<ULONG_PTR>(Handle)};
+    return value < Limit_k && (value & TagMask_k) == Tag_k &&
+           ((value >> KindShift_k) & 0xF) == ULONG_PTR(Type);
+}
+
+/**
+ * @brief Slot of a fake handle
+ */
+inline ULONG Slot(HANDLE Handle)
+{
+    return ULONG(reinterpret_cast<ULONG_PTR>(Handle) >> SlotShift_k);
+}
+
+} // namespace handles
+} // namespace ffmock
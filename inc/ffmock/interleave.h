@@ -0,0 +1,989 @@
+/**
+  @brief Deterministic interleaving explorer scheduling threads at mocked calls
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <ffmock/control.h>
+#include <handleapi.h>
+#include <intrin.h>
+#include <libloaderapi.h>
+#include <memoryapi.h>
+#include <processenv.h>
+#include <processthreadsapi.h>
+#include <synchapi.h>
+#include <sysinfoapi.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cwchar>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ffmock
+{
+namespace interleave
+{
+
+//! @brief Maximum number of threads run by a scheduler
+constexpr ULONG MaxThreads_k = 64;
+//! @brief Index of no thread
+constexpr ULONG None_k = MaxThreads_k;
+//! @brief Environment variable passing the seeds to explore to a child process
+constexpr wchar_t Environment_k[] = L"FFMOCK_INTERLEAVE";
+
+//! @brief Set of threads, a bit per thread index
+using Threads_t = ULONGLONG;
+
+//! @brief Set of a single thread
+constexpr Threads_t Bit(ULONG Index)
+{
+    return Threads_t(1) << Index;
+}
+
+//! @brief Number of threads in a set
+inline ULONG Count(Threads_t Set)
+{
+    ULONG count{};
+    for (; Set; Set &= Set - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+//! @brief Index of the Nth thread in a set (from 0)
+inline ULONG Nth(Threads_t Set, ULONGLONG N)
+{
+    for (ULONG index = 0; index < MaxThreads_k; ++index)
+    {
+        if (Set & Bit(index) && !N--)
+        {
+            return index;
+        }
+    }
+    return None_k;
+}
+
+/**
+ * @brief Choice of the thread to run at each scheduling point
+ *
+ * @details Strategies are seeded, so a run making the same calls makes the same
+ *          choices, and a failing schedule replays from its seed.
+ */
+class Strategy
+{
+public:
+    /**
+     * @brief Start a new run
+     *
+     * @param Threads - Number of threads in the run
+     */
+    virtual void Start(ULONG Threads) = 0;
+
+    /**
+     * @brief Choose the thread to run next
+     *
+     * @param Runnable - Threads which can run (never empty)
+     * @param Current - The running thread, or None_k if it blocked or returned
+     *
+     * @return ULONG - Index of a runnable thread
+     */
+    virtual ULONG Pick(Threads_t Runnable, ULONG Current) = 0;
+
+protected:
+    ~Strategy(void) = default;
+};
+
+/**
+ * @brief Random walk, choosing any runnable thread at each scheduling point
+ */
+class Random : public Strategy
+{
+public:
+    explicit Random(ULONGLONG Seed)
+        : Initial(Seed)
+    {
+    }
+
+    void Start(ULONG) override
+    {
+        Generator.seed(Initial);
+    }
+
+    ULONG Pick(Threads_t Runnable, ULONG) override
+    {
+        return Nth(Runnable, Generator() % Count(Runnable));
+    }
+
+private:
+    const ULONGLONG Initial;
+    std::mt19937_64 Generator;
+};
+
+/**
+ * @brief Probabilistic concurrency testing (PCT)
+ *
+ * @details Each thread gets a random priority, and the runnable thread with the
+ *          highest priority runs. At Depth - 1 random points among the first Steps,
+ *          the running thread drops below all the others. Each run finds a bug
+ *          needing Depth ordered events with a probability of at least
+ *          1 / (Threads * Steps ^ (Depth - 1)).
+ */
+class Pct : public Strategy
+{
+public:
+    /**
+     * @brief Construct a new Pct object
+     *
+     * @param Seed - Seed of the random priorities and change points
+     * @param Depth - Number of ordered events the bugs need (at least 1)
+     * @param Steps - Expected number of scheduling points in a run
+     */
+    Pct(ULONGLONG Seed, ULONG Depth, ULONG Steps)
+        : Initial(Seed)
+        , Limit((std::max)(Steps, 1ul))
+        , Changes((std::max)(Depth, 1ul) - 1)
+    {
+    }
+
+    void Start(ULONG Threads) override
+    {
+        Generator.seed(Initial);
+        Step = 0;
+        const ULONG lowest{ULONG(Changes.size()) + 1};
+        for (ULONG index = 0; index < Threads; ++index)
+        {
+            Priorities[index] = lowest + index;
+        }
+        for (ULONG index = Threads; index > 1; --index)
+        {
+            std::swap(Priorities[index - 1], Priorities[size_t(Generator() % index)]);
+        }
+        for (ULONGLONG& change : Changes)
+        {
+            change = 1 + Generator() % Limit;
+        }
+    }
+
+    ULONG Pick(Threads_t Runnable, ULONG Current) override
+    {
+        ++Step;
+        for (size_t change = 0; change < Changes.size() && Current != None_k; ++change)
+        {
+            if (Changes[change] == Step)
+            {
+                Priorities[Current] = ULONG(Changes.size() - change);
+            }
+        }
+        ULONG next{None_k};
+        for (ULONG index = 0; index < MaxThreads_k; ++index)
+        {
+            if (Runnable & Bit(index) && (next == None_k || Priorities[index] > Priorities[next]))
+            {
+                next = index;
+            }
+        }
+        return next;
+    }
+
+private:
+    const ULONGLONG Initial;
+    const ULONGLONG Limit;
+    //! @brief Steps at which the running thread drops to the lowest priorities
+    std::vector<ULONGLONG> Changes;
+    std::mt19937_64 Generator;
+    ULONGLONG Step{};
+    ULONG Priorities[MaxThreads_k]{};
+};
+
+/**
+ * @brief Random schedules with a bounded number of preemptions
+ *
+ * @details The running thread keeps running, except at Preemptions random points
+ *          among the first Steps, where another runnable thread takes over. A thread
+ *          which blocks or returns is replaced by a random runnable thread, which
+ *          isn't counted as a preemption. Most concurrency bugs need only one or two
+ *          preemptions.
+ */
+class Bounded : public Strategy
+{
+public:
+    /**
+     * @brief Construct a new Bounded object
+     *
+     * @param Seed - Seed of the random preemption points and threads
+     * @param Preemptions - Maximum number of preemptions in a run
+     * @param Steps - Expected number of scheduling points in a run
+     */
+    Bounded(ULONGLONG Seed, ULONG Preemptions, ULONG Steps)
+        : Initial(Seed)
+        , Limit((std::max)(Steps, 1ul))
+        , Points(Preemptions)
+    {
+    }
+
+    void Start(ULONG) override
+    {
+        Generator.seed(Initial);
+        Step = 0;
+        for (ULONGLONG& point : Points)
+        {
+            point = 1 + Generator() % Limit;
+        }
+    }
+
+    ULONG Pick(Threads_t Runnable, ULONG Current) override
+    {
+        ++Step;
+        if (Current != None_k)
+        {
+            const Threads_t others{Runnable & ~Bit(Current)};
+            if (!others || std::find(Points.begin(), Points.end(), Step) == Points.end())
+            {
+                return Current;
+            }
+            Runnable = others;
+        }
+        return Nth(Runnable, Generator() % Count(Runnable));
+    }
+
+private:
+    const ULONGLONG Initial;
+    const ULONGLONG Limit;
+    //! @brief Steps at which the running thread is preempted
+    std::vector<ULONGLONG> Points;
+    std::mt19937_64 Generator;
+    ULONGLONG Step{};
+};
+
+/**
+ * @brief Runs threads one at a time, switching between them only at mocked calls
+ *
+ * @details While a scheduler runs, each mocked API call made by one of its threads
+ *          is a scheduling point, where the strategy chooses the thread to run next.
+ *          Since a single thread runs at a time, the order of the calls, and of the
+ *          code between them, depends on the strategy alone.
+ *          Blocking calls go through a Mount, so a thread which can't take a lock
+ *          lets the others run. When all the threads wait for each other, the run
+ *          ends as deadlocked. Timed waits time out once no other thread can run.
+ *
+ * @note Threads created by the scheduled threads are not scheduled.
+ *       Locks held by threads which aren't scheduled are deemed never released.
+ *       The threads of a deadlocked run are parked until the process exits.
+ * @example
+ * @code {.cpp}
+ * ffmock::interleave::Pct strategy(seed, 2, 100);
+ * ffmock::interleave::Scheduler scheduler(strategy);
+ * Mocks::InterleaveMount mount;
+ *
+ * Cache cache;
+ * EXPECT_TRUE(scheduler.Run({[&] { cache.Put(1); }, [&] { cache.Evict(1); }}));
+ * EXPECT_TRUE(cache.Valid());
+ * @endcode
+ */
+class Scheduler
+{
+public:
+    explicit Scheduler(Strategy& Picker)
+        : Choose(Picker)
+    {
+    }
+
+    Scheduler(Scheduler const&) = delete;
+    Scheduler& operator=(Scheduler const&) = delete;
+
+    /**
+     * @brief Run routines on scheduled threads until they all return
+     *
+     * @param Routines - Routine of each thread (up to MaxThreads_k)
+     *
+     * @return true if all the routines returned, false if the run deadlocked
+     * @throws std::system_error if a thread could not be created
+     */
+    bool Run(std::vector<std::function<void(void)>> const& Routines)
+    {
+        _ASSERT(Routines.size() <= MaxThreads_k);
+        const ULONG count{ULONG((std::min)(Routines.size(), size_t(MaxThreads_k)))};
+        {
+            std::lock_guard<std::mutex> lock(Lock);
+            Live = count == MaxThreads_k ? ~Threads_t(0) : Bit(count) - 1;
+            Blocked = 0;
+            Parked = 0;
+            Finished = 0;
+            Running = None_k;
+            Cancelled = false;
+            Deadlock = false;
+            Switches = 0;
+            Order.clear();
+        }
+        std::vector<std::thread> threads;
+        threads.reserve(count);
+        try
+        {
+            for (ULONG index = 0; index < count; ++index)
+            {
+                threads.emplace_back([this, index, &Routines] { Work(index, Routines[index]); });
+            }
+        }
+        catch (std::system_error const&)
+        {
+            {
+                std::lock_guard<std::mutex> lock(Lock);
+                Cancelled = true;
+                Changed.notify_all();
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            throw;
+        }
+
+        Hook(true);
+        {
+            std::unique_lock<std::mutex> lock(Lock);
+            Choose.Start(count);
+            if (count)
+            {
+                Running = Next(Live, None_k);
+            }
+            Changed.notify_all();
+            Changed.wait(lock, [this, count] { return Finished + Count(Parked) == count; });
+        }
+        Hook(false);
+        for (ULONG index = 0; index < count; ++index)
+        {
+            if (Parked & Bit(index))
+            {
+                threads[index].detach();
+            }
+            else
+            {
+                threads[index].join();
+            }
+        }
+        return !Deadlock;
+    }
+
+    /**
+     * @brief Check if the last run deadlocked
+     */
+    bool Deadlocked(void) const
+    {
+        return Deadlock;
+    }
+
+    /**
+     * @brief Number of scheduling decisions in the last run
+     */
+    ULONGLONG Steps(void) const
+    {
+        return Order.size();
+    }
+
+    /**
+     * @brief Number of times the last run switched from a thread which could keep running
+     */
+    ULONG Preemptions(void) const
+    {
+        return Switches;
+    }
+
+    /**
+     * @brief Thread chosen at each scheduling decision of the last run
+     */
+    std::vector<ULONG> const& Trace(void) const
+    {
+        return Order;
+    }
+
+    /*************************************************************
+     * @brief Blocking mocks support
+     *************************************************************/
+
+    /**
+     * @brief Check if the calling thread is run by a scheduler
+     */
+    static bool Scheduled(void)
+    {
+        return Self.Owner != nullptr;
+    }
+
+    /**
+     * @brief Let the other threads run, while the calling thread can't make progress
+     *
+     * @details Blocking mocks call it between attempts of a non-blocking variant.
+     *
+     * @param Timeout - Timeout of the blocking call
+     *
+     * @return true to try again, or false if the call times out (no other thread
+     *         can run, and the timeout is finite)
+     */
+    static bool Wait(DWORD Timeout)
+    {
+        _ASSERT(Scheduled());
+        return Self.Owner->Block(Self.Index, Timeout);
+    }
+
+private:
+    /**
+     * @brief Thread run by a scheduler
+     */
+    struct Slot
+    {
+        Scheduler* Owner;
+        ULONG Index;
+    };
+
+    //! @brief Install the scheduling point into the mocks, while any scheduler runs
+    static void Hook(bool Install)
+    {
+        static std::mutex lock;
+        static LONG runs;
+        std::lock_guard<std::mutex> guard(lock);
+        if (Install ? !runs++ : !--runs)
+        {
+            MockRegistry::SetCallHook(Install ? &Scheduler::Preempt : nullptr);
+        }
+    }
+
+    //! @brief Scheduling point of the mocked calls
+    static void Preempt(ULONGLONG)
+    {
+        if (Self.Owner)
+        {
+            Self.Owner->Yield(Self.Index);
+        }
+    }
+
+    void Work(ULONG Index, std::function<void(void)> const& Routine)
+    {
+        {
+            std::unique_lock<std::mutex> lock(Lock);
+            Changed.wait(lock, [this, Index] { return Running == Index || Cancelled; });
+            if (Cancelled)
+            {
+                return;
+            }
+        }
+        Self = Slot{this, Index};
+        Routine();
+        Self = Slot{};
+
+        std::lock_guard<std::mutex> lock(Lock);
+        Live &= ~Bit(Index);
+        ++Finished;
+        // Returning is progress, the blocked threads may try again
+        Blocked = 0;
+        Running = Live ? Next(Live, None_k) : None_k;
+        Changed.notify_all();
+    }
+
+    void Yield(ULONG Index)
+    {
+        std::unique_lock<std::mutex> lock(Lock);
+        // A mocked call is progress, the blocked threads may try again
+        Blocked = 0;
+        Switch(lock, Index, Next(Live, Index));
+    }
+
+    bool Block(ULONG Index, DWORD Timeout)
+    {
+        std::unique_lock<std::mutex> lock(Lock);
+        Blocked |= Bit(Index);
+        const Threads_t runnable{Live & ~Blocked};
+        if (!runnable)
+        {
+            if (Timeout != INFINITE)
+            {
+                Blocked = 0;
+                return false;
+            }
+            // All the threads wait for each other
+            Deadlock = true;
+            Park(lock, Index);
+        }
+        Switch(lock, Index, Next(runnable, None_k));
+        return true;
+    }
+
+    //! @brief Hand over to the next thread, and wait for the turn of the calling one
+    void Switch(std::unique_lock<std::mutex>& Held, ULONG Index, ULONG Following)
+    {
+        if (Following == Index)
+        {
+            return;
+        }
+        Running = Following;
+        Changed.notify_all();
+        Changed.wait(Held, [this, Index] { return Running == Index || Deadlock; });
+        if (Deadlock)
+        {
+            Park(Held, Index);
+        }
+    }
+
+    //! @brief Never resume the calling thread of a deadlocked run
+    [[noreturn]] void Park(std::unique_lock<std::mutex>& Held, ULONG Index)
+    {
+        Parked |= Bit(Index);
+        Self = Slot{};
+        Changed.notify_all();
+        Held.unlock();
+        for (;;)
+        {
+            Sleep(INFINITE);
+        }
+    }
+
+    //! @brief Ask the strategy for the next thread to run (requires the lock)
+    ULONG Next(Threads_t Runnable, ULONG Current)
+    {
+        const ULONG next{Choose.Pick(Runnable, Current)};
+        _ASSERT(Runnable & Bit(next));
+        Order.push_back(next);
+        if (Current != None_k && next != Current)
+        {
+            ++Switches;
+        }
+        return next;
+    }
+
+    //! @brief Scheduler and index of the calling thread
+    static inline thread_local Slot Self{};
+
+    Strategy& Choose;
+    std::mutex Lock;
+    //! @brief Signaled when the running thread changes, or a thread returns or parks
+    std::condition_variable Changed;
+    Threads_t Live{};
+    //! @brief Threads which could not make progress since the last mocked call
+    Threads_t Blocked{};
+    Threads_t Parked{};
+    ULONG Finished{};
+    ULONG Running{None_k};
+    bool Cancelled{};
+    bool Deadlock{};
+    ULONG Switches{};
+    std::vector<ULONG> Order;
+};
+
+/**
+ * @brief Make the blocking synchronization mocks yield to the scheduler
+ *
+ * @details Threads which aren't run by a scheduler call the real APIs.
+ *
+ * @tparam EnterCriticalSection_t - Mock class of EnterCriticalSection()
+ * @tparam AcquireSRWLockExclusive_t - Mock class of AcquireSRWLockExclusive()
+ * @tparam AcquireSRWLockShared_t - Mock class of AcquireSRWLockShared()
+ * @tparam WaitForSingleObject_t - Mock class of WaitForSingleObject()
+ */
+template<typename EnterCriticalSection_t, typename AcquireSRWLockExclusive_t,
+         typename AcquireSRWLockShared_t, typename WaitForSingleObject_t>
+class Mount
+{
+public:
+    Mount(void)
+        : EnterGuard([](LPCRITICAL_SECTION Section)
+            {
+                if (!Scheduler::Scheduled())
+                {
+                    return EnterCriticalSection_t::Real(Section);
+                }
+                while (!TryEnterCriticalSection(Section))
+                {
+                    Scheduler::Wait(INFINITE);
+                }
+            })
+        , ExclusiveGuard([](PSRWLOCK Lock)
+            {
+                if (!Scheduler::Scheduled())
+                {
+                    return AcquireSRWLockExclusive_t::Real(Lock);
+                }
+                while (!TryAcquireSRWLockExclusive(Lock))
+                {
+                    Scheduler::Wait(INFINITE);
+                }
+            })
+        , SharedGuard([](PSRWLOCK Lock)
+            {
+                if (!Scheduler::Scheduled())
+                {
+                    return AcquireSRWLockShared_t::Real(Lock);
+                }
+                while (!TryAcquireSRWLockShared(Lock))
+                {
+                    Scheduler::Wait(INFINITE);
+                }
+            })
+        , WaitGuard([](HANDLE Handle, DWORD Timeout) -> DWORD
+            {
+                if (!Scheduler::Scheduled())
+                {
+                    return WaitForSingleObject_t::Real(Handle, Timeout);
+                }
+                for (;;)
+                {
+                    const DWORD result{WaitForSingleObject_t::Real(Handle, 0)};
+                    if (result != WAIT_TIMEOUT || !Timeout || !Scheduler::Wait(Timeout))
+                    {
+                        return result;
+                    }
+                }
+            })
+    {
+    }
+
+private:
+    typename EnterCriticalSection_t::Guard EnterGuard;
+    typename AcquireSRWLockExclusive_t::Guard ExclusiveGuard;
+    typename AcquireSRWLockShared_t::Guard SharedGuard;
+    typename WaitForSingleObject_t::Guard WaitGuard;
+};
+
+/**
+ * @brief Exploration settings
+ */
+struct Options
+{
+    ULONGLONG FirstSeed{1};     //!< Seed of the first schedule
+    ULONGLONG Seeds{1000};      //!< Number of schedules
+    ULONG Processes{1};         //!< Child processes (0 for one per processor, 1 explores in this process)
+    DWORD Timeout{10000};       //!< Milliseconds without progress before a child process is deemed hung
+    PCWSTR CommandLine{};       //!< Command line of the child processes (default to this process')
+};
+
+/**
+ * @brief Exploration results
+ */
+struct Report
+{
+    ULONGLONG Explored{};               //!< Number of schedules which passed
+    std::optional<ULONGLONG> Failed;    //!< Lowest failing seed
+};
+
+/**
+ * @brief Search for a failing schedule, over a range of seeds
+ *
+ * @details The trial runs the schedule of a seed, and returns false if it failed.
+ *          With several processes, each child process explores a contiguous part
+ *          of the range, and stops at its first failure, so the lowest failing seed
+ *          doesn't depend on the timing of the processes. A child process which
+ *          crashes, or hangs, fails on the seed it was running.
+ *          A child process starts over from its command line, and explores its seeds
+ *          in the Explore() call which spawned it, before exiting. The call is
+ *          identified by its call site, and the number of times the site was reached.
+ *          The other Explore() calls of the child return an empty report at once, so
+ *          checks of their reports should be skipped when Hosted().
+ *          The command line should reach the call quickly (e.g., with a gtest filter).
+ * @example
+ * @code {.cpp}
+ * auto trial = [](ULONGLONG Seed) { ffmock::interleave::Random strategy(Seed); ... };
+ * std::wstring commandLine{GetCommandLineW()};
+ * commandLine += L" --gtest_filter=CacheTestSuite.Test_Explore";
+ * ffmock::interleave::Explorer explorer({1, 100000, 0, 10000, commandLine.c_str()});
+ *
+ * ffmock::interleave::Report report{explorer.Explore(trial)};
+ * EXPECT_FALSE(report.Failed) << "Replay seed " << *report.Failed;
+ * @endcode
+ */
+class Explorer
+{
+public:
+    //! @brief Run the schedule of a seed, returning false if it failed
+    using Trial_t = std::function<bool(ULONGLONG Seed)>;
+
+    explicit Explorer(Options const& Settings = Options{})
+        : Config(Settings)
+    {
+    }
+
+    /**
+     * @brief Check if this process is a child process exploring seeds
+     */
+    static bool Hosted(void)
+    {
+        return GetEnvironmentVariableW(Environment_k, nullptr, 0) != 0;
+    }
+
+    /**
+     * @brief Explore the seeds, in this process or in child processes
+     *
+     * @param Trial - Runs the schedule of a seed
+     *
+     * @return Report - Results (in a child process, exits instead, or returns an
+     *                  empty report if another call spawned the process)
+     */
+    __declspec(noinline) Report Explore(Trial_t const& Trial)
+    {
+        const Call_t call{Identify(_ReturnAddress())};
+        WCHAR assignment[MAX_PATH]{};
+        if (GetEnvironmentVariableW(Environment_k, assignment, _countof(assignment)))
+        {
+            Serve(assignment, call, Trial);
+            return Report{};
+        }
+        ULONG processes{Config.Processes ? Config.Processes :
+                        (std::max)(std::thread::hardware_concurrency(), 1u)};
+        processes = ULONG((std::min)({ULONGLONG(processes), ULONGLONG(MAXIMUM_WAIT_OBJECTS), Config.Seeds}));
+        Report report;
+        if (processes <= 1 || !Spawn(processes, call, Trial, report))
+        {
+            Search(Config.FirstSeed, Config.Seeds, Trial, report);
+        }
+        return report;
+    }
+
+private:
+    /**
+     * @brief Progress of a child process, in shared memory
+     */
+    struct Progress
+    {
+        std::atomic<ULONGLONG> Seed;        //!< Seed being explored
+        std::atomic<ULONGLONG> Explored;    //!< Number of schedules which passed
+        std::atomic<LONG> Started;          //!< Set once the child reached its Explore() call
+    };
+
+    /**
+     * @brief Child process exploring part of the seeds
+     */
+    struct Child
+    {
+        HANDLE Process;
+        ULONG Slot;
+        ULONGLONG First;    //!< First seed to explore
+        ULONGLONG Seeds;    //!< Number of seeds to explore
+        ULONGLONG Seen;     //!< Progress when last checked
+        ULONGLONG Since;    //!< Tick count of the last progress
+    };
+
+    //! @brief Identity of an Explore() call: offset of its call site in the module, and occurrence of the site
+    using Call_t = std::pair<ULONGLONG, ULONG>;
+
+    //! @brief Milliseconds between checks of the progress of the child processes
+    static constexpr DWORD Poll_k = 100;
+
+    //! @brief Identify an Explore() call, returning to Site
+    static Call_t Identify(void* Site)
+    {
+        static std::mutex lock;
+        static std::vector<Call_t> reached;
+        HMODULE module{};
+        GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           static_cast<LPCWSTR>(Site), &module);
+        const ULONGLONG offset{ULONGLONG(static_cast<BYTE*>(Site) - reinterpret_cast<BYTE*>(module))};
+        std::lock_guard<std::mutex> guard(lock);
+        for (Call_t& site : reached)
+        {
+            if (site.first == offset)
+            {
+                return Call_t{offset, ++site.second};
+            }
+        }
+        reached.emplace_back(offset, 1);
+        return reached.back();
+    }
+
+    //! @brief Explore seeds in this process, stopping at the first failure
+    static void Search(ULONGLONG First, ULONGLONG Seeds, Trial_t const& Trial, Report& Results)
+    {
+        for (ULONGLONG seed = First; seed - First < Seeds; ++seed)
+        {
+            if (!Trial(seed))
+            {
+                if (!Results.Failed || seed < *Results.Failed)
+                {
+                    Results.Failed = seed;
+                }
+                return;
+            }
+            ++Results.Explored;
+        }
+    }
+
+    //! @brief Explore the seeds assigned by the test process and exit, if they are the call's
+    static void Serve(PCWSTR Assignment, Call_t const& Call, Trial_t const& Trial)
+    {
+        // "<slot> <first seed> <seeds> <call site> <occurrence> <section name>"
+        PWSTR next{};
+        const ULONG slot{wcstoul(Assignment, &next, 10)};
+        const ULONGLONG first{wcstoull(next, &next, 10)};
+        const ULONGLONG seeds{wcstoull(next, &next, 10)};
+        const ULONGLONG site{wcstoull(next, &next, 10)};
+        const ULONG occurrence{wcstoul(next, &next, 10)};
+        if (Call_t{site, occurrence} != Call)
+        {
+            return;
+        }
+        SetEnvironmentVariableW(Environment_k, nullptr);
+
+        UINT exitCode{ERROR_INVALID_PARAMETER};
+        HANDLE section{*next ? OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, next + 1) : nullptr};
+        Progress* progress{section ? static_cast<Progress*>(MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, 0)) :
+                                     nullptr};
+        if (progress)
+        {
+            progress += slot;
+            progress->Started.store(1);
+            exitCode = NO_ERROR;
+            for (ULONGLONG seed = first; seed - first < seeds; ++seed)
+            {
+                progress->Seed.store(seed);
+                if (!Trial(seed))
+                {
+                    exitCode = ERROR_INVALID_DATA;
+                    break;
+                }
+                progress->Explored.fetch_add(1);
+            }
+        }
+        // Skip the rest of the command line, and the threads of deadlocked runs
+        TerminateProcess(GetCurrentProcess(), exitCode);
+        for (;;)
+        {
+            Sleep(INFINITE);
+        }
+    }
+
+    //! @brief Explore the seeds in child processes
+    bool Spawn(ULONG Processes, Call_t const& Call, Trial_t const& Trial, Report& Results)
+    {
+        static std::atomic<LONG> instances;
+        std::wstring name{L"Local\\ffmock.interleave."};
+        name += std::to_wstring(GetCurrentProcessId()) + L"." + std::to_wstring(instances.fetch_add(1));
+        HANDLE section{CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                          0, DWORD(sizeof(Progress) * Processes), name.c_str())};
+        if (!section)
+        {
+            return false;
+        }
+        // Zero initialized by the OS
+        Progress* progress{static_cast<Progress*>(MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, 0))};
+        if (!progress)
+        {
+            CloseHandle(section);
+            return false;
+        }
+
+        std::vector<Child> children;
+        std::vector<HANDLE> running;
+        std::vector<std::pair<ULONGLONG, ULONGLONG>> orphans;
+        ULONGLONG first{Config.FirstSeed};
+        for (ULONG slot = 0; slot < Processes; ++slot)
+        {
+            const ULONGLONG seeds{Config.Seeds / Processes + (slot < Config.Seeds % Processes ? 1 : 0)};
+            progress[slot].Seed.store(first);
+            std::wstring commandLine{Config.CommandLine ? Config.CommandLine : GetCommandLineW()};
+            std::wstring assignment{std::to_wstring(slot) + L" " + std::to_wstring(first) + L" " +
+                                    std::to_wstring(seeds) + L" " + std::to_wstring(Call.first) + L" " +
+                                    std::to_wstring(Call.second) + L" " + name};
+            std::wstring environment{control::EnvironmentBlock(Environment_k, assignment.c_str())};
+            STARTUPINFOW startup{sizeof(startup)};
+            PROCESS_INFORMATION process{};
+
+            if (CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, FALSE,
+                               DETACHED_PROCESS | CREATE_UNICODE_ENVIRONMENT, environment.data(), nullptr,
+                               &startup, &process))
+            {
+                CloseHandle(process.hThread);
+                children.push_back(Child{process.hProcess, slot, first, seeds, 0, GetTickCount64()});
+                running.push_back(process.hProcess);
+            }
+            else
+            {
+                orphans.emplace_back(first, seeds);
+            }
+            first += seeds;
+        }
+
+        while (!running.empty())
+        {
+            const DWORD wait{WaitForMultipleObjects(DWORD(running.size()), running.data(), FALSE, Poll_k)};
+            if (wait < WAIT_OBJECT_0 + running.size())
+            {
+                const size_t index{wait - WAIT_OBJECT_0};
+                Child const& child{children[index]};
+                DWORD exitCode{};
+                GetExitCodeProcess(child.Process, &exitCode);
+                const ULONGLONG explored{progress[child.Slot].Explored.load()};
+                const ULONGLONG seed{progress[child.Slot].Seed.load()};
+                Results.Explored += explored;
+                // A child failing before its Explore() call didn't run the seed
+                if (exitCode != NO_ERROR && progress[child.Slot].Started.load())
+                {
+                    if (!Results.Failed || seed < *Results.Failed)
+                    {
+                        Results.Failed = seed;
+                    }
+                }
+                else if (explored < child.Seeds)
+                {
+                    // The command line exited, crashed or hung without reaching this Explore() call
+                    orphans.emplace_back(child.First + explored, child.Seeds - explored);
+                }
+                CloseHandle(child.Process);
+                children.erase(children.begin() + ptrdiff_t(index));
+                running.erase(running.begin() + ptrdiff_t(index));
+                continue;
+            }
+            // Terminate the child processes which made no progress in time
+            const ULONGLONG now{GetTickCount64()};
+            for (Child& child : children)
+            {
+                const ULONGLONG seen{progress[child.Slot].Seed.load() + progress[child.Slot].Explored.load()};
+                if (wait == WAIT_FAILED || (seen == child.Seen && now - child.Since >= Config.Timeout))
+                {
+                    TerminateProcess(child.Process, ERROR_TIMEOUT);
+                }
+                else if (seen != child.Seen)
+                {
+                    child.Seen = seen;
+                    child.Since = now;
+                }
+            }
+        }
+        UnmapViewOfFile(progress);
+        CloseHandle(section);
+
+        for (auto const& orphan : orphans)
+        {
+            Search(orphan.first, orphan.second, Trial, Results);
+        }
+        return true;
+    }
+
+    const Options Config;
+};
+
+} // namespace interleave
+} // namespace ffmock
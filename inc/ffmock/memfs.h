@@ -0,0 +1,750 @@
+/**
+  @brief In-memory filesystem for file APIs mocks
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <ffmock/handles.h>
+#include <errhandlingapi.h>
+#include <fileapi.h>
+#include <minwinbase.h>
+#include <synchapi.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cwctype>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ffmock
+{
+namespace memfs
+{
+
+//! @brief Size of the storage chunks
+constexpr size_t Page_k = 4096;
+//! @brief Maximum number of open handles
+constexpr ULONG Slots_k = 1024;
+
+/**
+ * @brief File operations which can be hooked
+ */
+enum class Operation
+{
+    Open,   //!< CreateFileW()
+    Read,   //!< ReadFile()
+    Write   //!< WriteFile()
+};
+
+/**
+ * @brief In-memory filesystem backing the file APIs mocks
+ *
+ * @details Files are stored in page-sized chunks. Reads copy straight from the
+ *          chunks into the caller's buffer, and writes copy straight into them.
+ *          Chunks are shared by snapshots and copied on the first write after a
+ *          snapshot, so Save() and Restore() do not copy file data.
+ *          Open files are kept in a slot table and returned as fake handles (see
+ *          handles.h). File names are case insensitive, and directories are implied
+ *          by the files' names. Sharing modes, attributes and flags are ignored.
+ *
+ * @example
+ * @code {.cpp}
+ * ffmock::memfs::FileSystem fs;
+ * Mocks::FileSystemMount mount(fs);
+ *
+ * fs.Store(L"C:\\Config\\app.ini", "[app]\r\n", 7);
+ * fs.Fault(L"C:\\Config\\app.ini", ffmock::memfs::Operation::Read, ERROR_CRC);
+ * EXPECT_FALSE(Config().Load(L"C:\\Config\\app.ini"));
+ * @endcode
+ */
+class FileSystem
+{
+public:
+    /**
+     * @brief Storage chunk
+     */
+    struct Page
+    {
+        BYTE Data[Page_k];
+    };
+
+    /**
+     * @brief Contents of a file
+     */
+    struct Contents
+    {
+        std::vector<std::shared_ptr<Page>> Pages;   //!< Missing pages read as zeros
+        ULONGLONG Size{};                           //!< File size in bytes
+    };
+
+    //! @brief Saved contents of all files
+    using Snapshot = std::unordered_map<std::wstring, Contents>;
+
+    FileSystem(void)
+    {
+        Free.reserve(Slots_k);
+        for (ULONG slot = Slots_k; slot; --slot)
+        {
+            Free.push_back(slot - 1);
+        }
+    }
+
+    FileSystem(FileSystem const&) = delete;
+    FileSystem& operator=(FileSystem const&) = delete;
+
+    /**
+     * @brief Create or replace a file
+     *
+     * @param Name - Path of the file
+     * @param Data - File contents
+     * @param Size - Size of the contents in bytes
+     */
+    void Store(PCWSTR Name, const void* Data, size_t Size)
+    {
+        std::shared_ptr<Node> node;
+        {
+            const std::wstring key{Key(Name)};
+            Exclusive lock(Lock);
+            auto file = Files.find(key);
+            node = file != Files.end() ? file->second : Create(key);
+        }
+        Exclusive lock(node->Lock);
+        node->Data = Contents{};
+        Copy(node->Data, 0, Data, Size);
+    }
+
+    /**
+     * @brief Create or replace a file
+     *
+     * @param Name - Path of the file
+     * @param Data - File contents
+     */
+    void Store(PCWSTR Name, std::string const& Data)
+    {
+        Store(Name, Data.data(), Data.size());
+    }
+
+    /**
+     * @brief Contents of a file
+     *
+     * @param Name - Path of the file
+     *
+     * @return std::string - File contents, empty if the file does not exist
+     */
+    std::string Load(PCWSTR Name) const
+    {
+        std::string data;
+        if (std::shared_ptr<Node> node{Find(Name)})
+        {
+            Shared lock(node->Lock);
+            data.resize(size_t(node->Data.Size));
+            Copy(&data[0], node->Data, 0, data.size());
+        }
+        return data;
+    }
+
+    /**
+     * @brief Check if the file exists
+     */
+    bool Exists(PCWSTR Name) const
+    {
+        return !!Find(Name);
+    }
+
+    /**
+     * @brief Delete a file (open handles keep their contents)
+     *
+     * @return true if the file existed
+     */
+    bool Remove(PCWSTR Name)
+    {
+        Exclusive lock(Lock);
+        return Files.erase(Key(Name)) != 0;
+    }
+
+    /**
+     * @brief Save the contents of all files
+     *
+     * @return Snapshot - Saved state to pass to Restore()
+     */
+    Snapshot Save(void) const
+    {
+        Snapshot saved;
+        Shared lock(Lock);
+        for (auto const& file : Files)
+        {
+            Shared fileLock(file.second->Lock);
+            saved.emplace(file.first, file.second->Data);
+        }
+        return saved;
+    }
+
+    /**
+     * @brief Restore the contents of all files
+     *
+     * @details Open handles keep the contents they had before the restore.
+     *
+     * @param Saved - State returned by Save()
+     */
+    void Restore(Snapshot const& Saved)
+    {
+        std::unordered_map<std::wstring, std::shared_ptr<Node>> files;
+        for (auto const& file : Saved)
+        {
+            files.emplace(file.first, std::make_shared<Node>(file.second));
+        }
+
+        Exclusive lock(Lock);
+        for (auto& file : files)
+        {
+            auto hooks = Hooked.find(file.first);
+            if (hooks != Hooked.end())
+            {
+                file.second->Hooked = hooks->second;
+            }
+        }
+        Files.swap(files);
+    }
+
+    /**
+     * @brief Fail an operation on a file
+     *
+     * @param Name - Path of the file (need not exist yet)
+     * @param Type - The failing operation
+     * @param Error - Last error to set
+     * @param Skip - Number of calls to let through before failing
+     * @param Count - Number of calls to fail
+     */
+    void Fault(PCWSTR Name, Operation Type, DWORD Error, LONG Skip = 0, LONG Count = LONG_MAX)
+    {
+        Hook& hook{Hooks(Name)->Operations[size_t(Type)]};
+        hook.Calls.store(0);
+        hook.Skip.store(Skip);
+        hook.Count.store(Count);
+        hook.Error.store(Error);
+    }
+
+    /**
+     * @brief Delay an operation on a file
+     *
+     * @param Name - Path of the file (need not exist yet)
+     * @param Type - The delayed operation
+     * @param Milliseconds - Time to wait before the operation
+     */
+    void Latency(PCWSTR Name, Operation Type, DWORD Milliseconds)
+    {
+        Hooks(Name)->Operations[size_t(Type)].Latency.store(Milliseconds);
+    }
+
+    /**
+     * @brief Remove all faults and latencies
+     */
+    void ClearHooks(void)
+    {
+        Exclusive lock(Lock);
+        for (auto& file : Files)
+        {
+            file.second->Hooked.reset();
+        }
+        Hooked.clear();
+    }
+
+    /**
+     * @brief Check if the handle belongs to an in-memory file
+     */
+    static bool Owns(HANDLE Handle)
+    {
+        return handles::Is(Handle, handles::Kind::File) && handles::Slot(Handle) < Slots_k;
+    }
+
+    /**
+     * @brief Implementation of CreateFileW()
+     *
+     * @param Name - Path of the file
+     * @param Access - Requested access (GENERIC_READ, GENERIC_WRITE, ...)
+     * @param Disposition - CREATE_NEW, CREATE_ALWAYS, OPEN_EXISTING, ...
+     *
+     * @return HANDLE - Fake handle, or INVALID_HANDLE_VALUE setting the last error
+     */
+    HANDLE Open(LPCWSTR Name, DWORD Access, DWORD Disposition)
+    {
+        if (!Name || !*Name)
+        {
+            SetLastError(ERROR_PATH_NOT_FOUND);
+            return INVALID_HANDLE_VALUE;
+        }
+
+        const std::wstring key{Key(Name)};
+        DWORD error{Before(key, Operation::Open)};
+        if (error)
+        {
+            SetLastError(error);
+            return INVALID_HANDLE_VALUE;
+        }
+
+        Exclusive lock(Lock);
+        auto file = Files.find(key);
+        const bool exists{file != Files.end()};
+        if (exists && Disposition == CREATE_NEW)
+        {
+            error = ERROR_FILE_EXISTS;
+        }
+        else if (!exists && (Disposition == OPEN_EXISTING || Disposition == TRUNCATE_EXISTING))
+        {
+            error = ERROR_FILE_NOT_FOUND;
+        }
+        else if (Disposition < CREATE_NEW || Disposition > TRUNCATE_EXISTING)
+        {
+            error = ERROR_INVALID_PARAMETER;
+        }
+        else if (Free.empty())
+        {
+            error = ERROR_TOO_MANY_OPEN_FILES;
+        }
+        if (error)
+        {
+            SetLastError(error);
+            return INVALID_HANDLE_VALUE;
+        }
+
+        std::shared_ptr<Node> node{exists ? file->second : Create(key)};
+        if (exists && (Disposition == CREATE_ALWAYS || Disposition == TRUNCATE_EXISTING))
+        {
+            Exclusive fileLock(node->Lock);
+            node->Data = Contents{};
+        }
+
+        const ULONG slot{Free.back()};
+        Free.pop_back();
+        Slots[slot].File = std::move(node);
+        Slots[slot].Position.store(0);
+        Slots[slot].Access = Access;
+        SetLastError(exists && (Disposition == CREATE_ALWAYS || Disposition == OPEN_ALWAYS) ?
+                     ERROR_ALREADY_EXISTS : NO_ERROR);
+        return handles::Make(handles::Kind::File, slot);
+    }
+
+    /**
+     * @brief Implementation of ReadFile()
+     *
+     * @details Overlapped reads complete synchronously at the given offset.
+     */
+    BOOL Read(HANDLE Handle, LPVOID Buffer, DWORD Size, LPDWORD Read, LPOVERLAPPED Overlapped)
+    {
+        Open_t file{Get(Handle, GENERIC_READ | FILE_READ_DATA)};
+        DWORD error{file.Error};
+        if (!error)
+        {
+            error = Before(file.File->Hooked, Operation::Read);
+        }
+        if (error)
+        {
+            SetLastError(error);
+            return FALSE;
+        }
+
+        const ULONGLONG position{Overlapped ? Offset(Overlapped) : file.Entry->Position.load()};
+        DWORD count;
+        {
+            Shared lock(file.File->Lock);
+            const ULONGLONG size{file.File->Data.Size};
+            count = position < size ? DWORD((std::min)(ULONGLONG(Size), size - position)) : 0;
+            Copy(Buffer, file.File->Data, position, count);
+        }
+
+        if (Read)
+        {
+            *Read = count;
+        }
+        if (Overlapped)
+        {
+            return Complete(Overlapped, count, !count && Size ? ERROR_HANDLE_EOF : NO_ERROR);
+        }
+        file.Entry->Position.store(position + count);
+        return TRUE;
+    }
+
+    /**
+     * @brief Implementation of WriteFile()
+     *
+     * @details Overlapped writes complete synchronously at the given offset.
+     *          Handles opened with FILE_APPEND_DATA only write at the end.
+     */
+    BOOL Write(HANDLE Handle, LPCVOID Buffer, DWORD Size, LPDWORD Written, LPOVERLAPPED Overlapped)
+    {
+        Open_t file{Get(Handle, GENERIC_WRITE | FILE_WRITE_DATA | FILE_APPEND_DATA)};
+        DWORD error{file.Error};
+        if (!error)
+        {
+            error = Before(file.File->Hooked, Operation::Write);
+        }
+        if (error)
+        {
+            SetLastError(error);
+            return FALSE;
+        }
+
+        const bool append{(file.Entry->Access & (GENERIC_WRITE | FILE_WRITE_DATA | GENERIC_ALL)) == 0};
+        ULONGLONG position;
+        {
+            Exclusive lock(file.File->Lock);
+            position = append ? file.File->Data.Size :
+                       Overlapped ? Offset(Overlapped) : file.Entry->Position.load();
+            Copy(file.File->Data, position, Buffer, Size);
+        }
+
+        if (Written)
+        {
+            *Written = Size;
+        }
+        if (Overlapped)
+        {
+            return Complete(Overlapped, Size, NO_ERROR);
+        }
+        file.Entry->Position.store(position + Size);
+        return TRUE;
+    }
+
+    /**
+     * @brief Implementation of CloseHandle()
+     */
+    BOOL Close(HANDLE Handle)
+    {
+        Exclusive lock(Lock);
+        const ULONG slot{handles::Slot(Handle)};
+        if (!Owns(Handle) || !Slots[slot].File)
+        {
+            SetLastError(ERROR_INVALID_HANDLE);
+            return FALSE;
+        }
+        Slots[slot].File.reset();
+        Free.push_back(slot);
+        return TRUE;
+    }
+
+private:
+    /**
+     * @brief Fault and latency of an operation
+     */
+    struct Hook
+    {
+        std::atomic<LONG> Calls{};
+        std::atomic<LONG> Skip{};
+        std::atomic<LONG> Count{};
+        std::atomic<DWORD> Error{};
+        std::atomic<DWORD> Latency{};
+    };
+
+    /**
+     * @brief Hooks of a file
+     */
+    struct FileHooks
+    {
+        Hook Operations[3];
+    };
+
+    /**
+     * @brief A file
+     */
+    struct Node
+    {
+        Node(void) = default;
+        explicit Node(Contents const& Initial) : Data(Initial) {}
+
+        mutable std::shared_mutex Lock;
+        Contents Data;
+        std::shared_ptr<FileHooks> Hooked;
+    };
+
+    /**
+     * @brief Open file
+     */
+    struct Slot
+    {
+        std::shared_ptr<Node> File;
+        std::atomic<ULONGLONG> Position{};
+        DWORD Access{};
+    };
+
+    /**
+     * @brief Open file looked up by handle
+     */
+    struct Open_t
+    {
+        std::shared_ptr<Node> File;
+        Slot* Entry;
+        DWORD Error;
+    };
+
+    /**
+     * @brief Scoped locks
+     *
+     * @details Not SRW locks, so mocks of the SRW lock APIs (e.g., a contention
+     *          profiler) don't see the filesystem's own locking.
+     */
+    using Exclusive = std::unique_lock<std::shared_mutex>;
+    using Shared = std::shared_lock<std::shared_mutex>;
+
+    static std::wstring Key(PCWSTR Name)
+    {
+        std::wstring key{Name};
+        for (wchar_t& c : key)
+        {
+            c = c == L'/' ? L'\\' : wchar_t(std::towlower(c));
+        }
+        return key;
+    }
+
+    static ULONGLONG Offset(LPOVERLAPPED Overlapped)
+    {
+        return ULONGLONG(Overlapped->OffsetHigh) << 32 | Overlapped->Offset;
+    }
+
+    static BOOL Complete(LPOVERLAPPED Overlapped, DWORD Transferred, DWORD Error)
+    {
+        // STATUS_END_OF_FILE is the only error
+        Overlapped->Internal = Error ? ULONG_PTR(0xC0000011L) : 0;
+        Overlapped->InternalHigh = Transferred;
+        if (Overlapped->hEvent)
+        {
+            SetEvent(Overlapped->hEvent);
+        }
+        if (Error)
+        {
+            SetLastError(Error);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /**
+     * @brief Copy file contents into a buffer, reading missing pages as zeros
+     */
+    static void Copy(void* Buffer, Contents const& Data, ULONGLONG Position, size_t Size)
+    {
+        BYTE* buffer{static_cast<BYTE*>(Buffer)};
+        while (Size)
+        {
+            const size_t index{size_t(Position / Page_k)};
+            const size_t offset{size_t(Position % Page_k)};
+            const size_t count{(std::min)(Size, Page_k - offset)};
+            if (index < Data.Pages.size() && Data.Pages[index])
+            {
+                memcpy(buffer, Data.Pages[index]->Data + offset, count);
+            }
+            else
+            {
+                memset(buffer, 0, count);
+            }
+            buffer += count;
+            Position += count;
+            Size -= count;
+        }
+    }
+
+    /**
+     * @brief Copy a buffer into the file contents, copying pages shared with snapshots
+     */
+    static void Copy(Contents& Data, ULONGLONG Position, const void* Buffer, size_t Size)
+    {
+        const BYTE* buffer{static_cast<const BYTE*>(Buffer)};
+        if (Position + Size > Data.Size)
+        {
+            Data.Size = Position + Size;
+            Data.Pages.resize(size_t((Data.Size + Page_k - 1) / Page_k));
+        }
+        while (Size)
+        {
+            const size_t index{size_t(Position / Page_k)};
+            const size_t offset{size_t(Position % Page_k)};
+            const size_t count{(std::min)(Size, Page_k - offset)};
+            std::shared_ptr<Page>& page{Data.Pages[index]};
+            if (!page)
+            {
+                page = std::make_shared<Page>();
+            }
+            else if (page.use_count() > 1)
+            {
+                page = std::make_shared<Page>(*page);
+            }
+            memcpy(page->Data + offset, buffer, count);
+            buffer += count;
+            Position += count;
+            Size -= count;
+        }
+    }
+
+    std::shared_ptr<Node> Find(PCWSTR Name) const
+    {
+        const std::wstring key{Key(Name)};
+        Shared lock(Lock);
+        auto file = Files.find(key);
+        return file != Files.end() ? file->second : nullptr;
+    }
+
+    //! @brief Create a file (requires the exclusive lock)
+    std::shared_ptr<Node> Create(std::wstring const& Key)
+    {
+        std::shared_ptr<Node> node{std::make_shared<Node>()};
+        auto hooks = Hooked.find(Key);
+        if (hooks != Hooked.end())
+        {
+            node->Hooked = hooks->second;
+        }
+        Files.emplace(Key, node);
+        return node;
+    }
+
+    std::shared_ptr<FileHooks> Hooks(PCWSTR Name)
+    {
+        const std::wstring key{Key(Name)};
+        Exclusive lock(Lock);
+        std::shared_ptr<FileHooks>& hooks{Hooked[key]};
+        if (!hooks)
+        {
+            hooks = std::make_shared<FileHooks>();
+            auto file = Files.find(key);
+            if (file != Files.end())
+            {
+                file->second->Hooked = hooks;
+            }
+        }
+        return hooks;
+    }
+
+    Open_t Get(HANDLE Handle, DWORD Access)
+    {
+        Shared lock(Lock);
+        Slot* slot{Owns(Handle) ? &Slots[handles::Slot(Handle)] : nullptr};
+        if (!slot || !slot->File)
+        {
+            return Open_t{nullptr, nullptr, ERROR_INVALID_HANDLE};
+        }
+        if (!(slot->Access & (Access | GENERIC_ALL)))
+        {
+            return Open_t{nullptr, nullptr, ERROR_ACCESS_DENIED};
+        }
+        return Open_t{slot->File, slot, NO_ERROR};
+    }
+
+    DWORD Before(std::wstring const& Key, Operation Type)
+    {
+        std::shared_ptr<FileHooks> hooks;
+        {
+            Shared lock(Lock);
+            auto found = Hooked.find(Key);
+            if (found == Hooked.end())
+            {
+                return NO_ERROR;
+            }
+            hooks = found->second;
+        }
+        return Before(hooks, Type);
+    }
+
+    /**
+     * @brief Apply the latency and fault of an operation
+     *
+     * @return DWORD - Error to fail the operation with, or NO_ERROR
+     */
+    static DWORD Before(std::shared_ptr<FileHooks> const& Hooks, Operation Type)
+    {
+        if (!Hooks)
+        {
+            return NO_ERROR;
+        }
+        Hook& hook{Hooks->Operations[size_t(Type)]};
+        if (const DWORD latency{hook.Latency.load()})
+        {
+            Sleep(latency);
+        }
+        const DWORD error{hook.Error.load()};
+        if (!error)
+        {
+            return NO_ERROR;
+        }
+        const LONG call{hook.Calls.fetch_add(1)};
+        const LONG skip{hook.Skip.load()};
+        return call >= skip && call - skip < hook.Count.load() ? error : NO_ERROR;
+    }
+
+    mutable std::shared_mutex Lock;
+    std::unordered_map<std::wstring, std::shared_ptr<Node>> Files;
+    std::unordered_map<std::wstring, std::shared_ptr<FileHooks>> Hooked;
+    Slot Slots[Slots_k];
+    std::vector<ULONG> Free;
+};
+
+/**
+ * @brief Redirect the file APIs mocks to an in-memory filesystem
+ *
+ * @details Handles which are not owned by the filesystem (e.g., console or events)
+ *          are passed to the real APIs.
+ *
+ * @tparam CreateFileW_t - Mock class of CreateFileW()
+ * @tparam ReadFile_t - Mock class of ReadFile()
+ * @tparam WriteFile_t - Mock class of WriteFile()
+ * @tparam CloseHandle_t - Mock class of CloseHandle()
+ */
+template<typename CreateFileW_t, typename ReadFile_t, typename WriteFile_t, typename CloseHandle_t>
+class Mount
+{
+public:
+    explicit Mount(FileSystem& Files)
+        : CreateFileGuard([&Files](LPCWSTR Name, DWORD Access, DWORD, LPSECURITY_ATTRIBUTES,
+                                   DWORD Disposition, DWORD, HANDLE) -> HANDLE
+            {
+                return Files.Open(Name, Access, Disposition);
+            })
+        , ReadFileGuard([&Files](HANDLE Handle, LPVOID Buffer, DWORD Size, LPDWORD Read,
+                                 LPOVERLAPPED Overlapped) -> BOOL
+            {
+                return FileSystem::Owns(Handle) ? Files.Read(Handle, Buffer, Size, Read, Overlapped) :
+                       ReadFile_t::Real(Handle, Buffer, Size, Read, Overlapped);
+            })
+        , WriteFileGuard([&Files](HANDLE Handle, LPCVOID Buffer, DWORD Size, LPDWORD Written,
+                                  LPOVERLAPPED Overlapped) -> BOOL
+            {
+                return FileSystem::Owns(Handle) ? Files.Write(Handle, Buffer, Size, Written, Overlapped) :
+                       WriteFile_t::Real(Handle, Buffer, Size, Written, Overlapped);
+            })
+        , CloseHandleGuard([&Files](HANDLE Handle) -> BOOL
+            {
+                return FileSystem::Owns(Handle) ? Files.Close(Handle) : CloseHandle_t::Real(Handle);
+            })
+    {
+    }
+
+private:
+    typename CreateFileW_t::Guard CreateFileGuard;
+    typename ReadFile_t::Guard ReadFileGuard;
+    typename WriteFile_t::Guard WriteFileGuard;
+    typename CloseHandle_t::Guard CloseHandleGuard;
+};
+
+} // namespace memfs
+} // namespace ffmock
@@ -0,0 +1,49 @@
+/**
+  @brief Precompiled header for mocks libraries
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+/**
+ * @details ffmock.h only depends on FFMOCK_IMPORT, which is set for the whole
+ *          target, so it can be precompiled (or imported as a header unit) once
+ *          and shared by all the mocks sources. Declarations made by the mocks
+ *          (DECLARE_MOCK, DEFINE_MOCK, ...) are macros and stay in the sources.
+ *
+ * @example
+ * @code {.cmake}
+ * target_precompile_headers(Mocks_dll PRIVATE ${CMAKE_SOURCE_DIR}/inc/ffmock/precompiled.h)
+ * @endcode
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <minwindef.h>
+#include <winerror.h>
+#include <libloaderapi.h>
+#include <ffmock/ffmock.h>
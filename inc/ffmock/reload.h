@@ -0,0 +1,465 @@
+/**
+  @brief Mocks implemented by a library reloaded in the running process
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <fileapi.h>
+#include <libloaderapi.h>
+#include <winbase.h>
+#include <sysinfoapi.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ffmock
+{
+namespace reload
+{
+
+/**
+ * @brief Receiver of the library's module on each (re)load
+ */
+class Bindable
+{
+public:
+    /**
+     * @brief Resolve the exports of the module
+     *
+     * @param Module - The loaded library, or nullptr once unloaded
+     */
+    virtual void Rebind(HMODULE Module) = 0;
+
+protected:
+    ~Bindable(void) = default;
+};
+
+/**
+ * @brief Library of mocks implementations, which can be reloaded in the running process
+ *
+ * @details A copy of the library is loaded, so the build can replace the library
+ *          while it is in use. Reload() loads a new copy, waits for the calls in the
+ *          library to return, then rebinds all the mocks to the new copy before
+ *          unloading the previous one. Calls made while reloading wait for it.
+ *          A failed reload keeps the previous copy.
+ *
+ * @note The bindings must be destroyed before the library.
+ *
+ * @example
+ * @code {.cpp}
+ * ffmock::reload::Library library(L"MyMocks.dll");
+ * ffmock::reload::Binding<Mocks::FFRegOpenKeyW> open(library, "Mock_RegOpenKeyW");
+ * for (;;)
+ * {
+ *     RunTests();
+ *     while (!library.Changed()) Sleep(500);
+ *     library.Reload();
+ * }
+ * @endcode
+ */
+class Library
+{
+public:
+    /**
+     * @brief Construct a new Library object, loading the library
+     *
+     * @param Path - Full path of the library
+     */
+    explicit Library(PCWSTR Path)
+        : Source(Path)
+    {
+        std::lock_guard<std::mutex> lock(Reloader);
+        HMODULE module{};
+        std::wstring copy;
+        FILETIME written{};
+        if (Load(module, copy, written))
+        {
+            Adopt(module, copy, written);
+        }
+    }
+
+    Library(Library const&) = delete;
+    Library& operator=(Library const&) = delete;
+
+    /**
+     * @brief Destroy the Library object after the calls in the library returned
+     */
+    ~Library(void)
+    {
+        std::lock_guard<std::mutex> lock(Reloader);
+        Drain(INFINITE);
+        for (Bindable* binding : Bindings)
+        {
+            binding->Rebind(nullptr);
+        }
+        Unload(Current, Copy);
+    }
+
+    /**
+     * @brief Check if a copy of the library is loaded
+     */
+    bool Loaded(void) const
+    {
+        return Current != nullptr;
+    }
+
+    /**
+     * @brief Number of successful loads
+     */
+    ULONG Generation(void) const
+    {
+        return Loads.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of calls running in the library (test helper)
+     */
+    LONG InFlight(void) const
+    {
+        return Calls.load();
+    }
+
+    /**
+     * @brief Check if the library was rebuilt since it was loaded
+     */
+    bool Changed(void) const
+    {
+        FILETIME written{};
+        return LastWrite(written) && CompareFileTime(&written, &Written) != 0;
+    }
+
+    /**
+     * @brief Load the current library, and rebind the mocks to it
+     *
+     * @param Timeout - Milliseconds to wait for the calls in the library to return
+     *
+     * @return true if successful, otherwise false with the last error set
+     *         (ERROR_TIMEOUT if calls didn't return in time)
+     */
+    bool Reload(DWORD Timeout = INFINITE)
+    {
+        if (Inside == this)
+        {
+            // A mock can't wait for itself to return
+            SetLastError(ERROR_BUSY);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(Reloader);
+        HMODULE module{};
+        std::wstring copy;
+        FILETIME written{};
+        if (!Load(module, copy, written))
+        {
+            return false;
+        }
+        if (!Drain(Timeout))
+        {
+            Unload(module, copy);
+            SetLastError(ERROR_TIMEOUT);
+            return false;
+        }
+        for (Bindable* binding : Bindings)
+        {
+            binding->Rebind(module);
+        }
+        HMODULE previous{Current};
+        std::wstring previousCopy{Copy};
+        Adopt(module, copy, written);
+        Reloading.store(false);
+        Unload(previous, previousCopy);
+        return true;
+    }
+
+    /**
+     * @brief Call running in the library
+     *
+     * @details The library isn't reloaded until the call returns. Calls nested in
+     *          a call in the same library are counted once.
+     */
+    class Call
+    {
+    public:
+        explicit Call(Library& Target)
+            : Owner(Target)
+            , Previous(Inside)
+            , Counted(Target.Enter())
+        {
+            Inside = &Target;
+        }
+
+        ~Call(void)
+        {
+            Inside = Previous;
+            if (Counted)
+            {
+                Owner.Calls.fetch_sub(1);
+            }
+        }
+
+        Call(Call const&) = delete;
+        Call& operator=(Call const&) = delete;
+
+    private:
+        Library& Owner;
+        const Library* const Previous;
+        const bool Counted;
+    };
+
+    /**
+     * @brief Add a mock to rebind on each reload, and bind it to the loaded copy
+     */
+    void Attach(Bindable& Mock)
+    {
+        std::lock_guard<std::mutex> lock(Reloader);
+        Bindings.push_back(&Mock);
+        Mock.Rebind(Current);
+    }
+
+    /**
+     * @brief Remove a mock, and unbind it once the calls in the library returned
+     *
+     * @details Called from a call in the library, the other calls aren't waited for,
+     *          since the call would wait for itself.
+     */
+    void Detach(Bindable& Mock)
+    {
+        std::lock_guard<std::mutex> lock(Reloader);
+        const bool drained{Inside != this && Drain(INFINITE)};
+        Bindings.erase(std::remove(Bindings.begin(), Bindings.end(), &Mock), Bindings.end());
+        Mock.Rebind(nullptr);
+        if (drained)
+        {
+            Reloading.store(false);
+        }
+    }
+
+private:
+    //! @brief Count a call, waiting for a reload in progress
+    bool Enter(void)
+    {
+        if (Inside == this)
+        {
+            return false;
+        }
+        for (;;)
+        {
+            while (Reloading.load())
+            {
+                std::this_thread::yield();
+            }
+            Calls.fetch_add(1);
+            if (!Reloading.load())
+            {
+                return true;
+            }
+            Calls.fetch_sub(1);
+        }
+    }
+
+    //! @brief Stop new calls, and wait for the running ones to return (requires the lock)
+    bool Drain(DWORD Timeout)
+    {
+        Reloading.store(true);
+        const ULONGLONG start{GetTickCount64()};
+        while (Calls.load())
+        {
+            if (Timeout != INFINITE && GetTickCount64() - start >= Timeout)
+            {
+                Reloading.store(false);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    bool LastWrite(FILETIME& Time) const
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data{};
+        if (!GetFileAttributesExW(Source.c_str(), GetFileExInfoStandard, &data))
+        {
+            return false;
+        }
+        Time = data.ftLastWriteTime;
+        return true;
+    }
+
+    //! @brief Load a new copy of the library (requires the lock)
+    bool Load(HMODULE& Module, std::wstring& Path, FILETIME& Time)
+    {
+        if (!LastWrite(Time))
+        {
+            return false;
+        }
+        // Next to the library, so its dependencies are found the same way
+        Path = Source + L"." + std::to_wstring(Loads.load(std::memory_order_relaxed) + 1) + L".dll";
+        if (!CopyFileW(Source.c_str(), Path.c_str(), FALSE))
+        {
+            return false;
+        }
+        Module = LoadLibraryExW(Path.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH);
+        if (!Module)
+        {
+            const DWORD error{GetLastError()};
+            DeleteFileW(Path.c_str());
+            SetLastError(error);
+            return false;
+        }
+        return true;
+    }
+
+    //! @brief Make a new copy the current one (requires the lock)
+    void Adopt(HMODULE Module, std::wstring const& Path, FILETIME const& Time)
+    {
+        Current = Module;
+        Copy = Path;
+        Written = Time;
+        Loads.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    static void Unload(HMODULE Module, std::wstring const& Path)
+    {
+        if (Module)
+        {
+            FreeLibrary(Module);
+            DeleteFileW(Path.c_str());
+        }
+    }
+
+    //! @brief Library of the mock call running on the thread
+    static inline thread_local const Library* Inside{};
+
+    const std::wstring Source;
+    std::mutex Reloader;
+    std::vector<Bindable*> Bindings;
+    HMODULE Current{};
+    std::wstring Copy;
+    FILETIME Written{};
+    std::atomic<ULONG> Loads{};
+    std::atomic<LONG> Calls{};
+    std::atomic<bool> Reloading{};
+};
+
+/**
+ * @brief Mock behavior calling a function exported by a reloadable library
+ *
+ * @details The export is resolved into a single pointer, replaced atomically on
+ *          each reload. Calls pass to the real API while the library doesn't export
+ *          the function (e.g., it isn't loaded, or a new version dropped it).
+ *          The export has the API's signature, and an undecorated name.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ * @example
+ * @code {.cpp}
+ * // Library
+ * extern "C" LSTATUS APIENTRY Mock_RegOpenKeyW(HKEY, LPCWSTR, PHKEY Result)
+ * {
+ *     #pragma comment(linker, "/EXPORT:" __FUNCTION__ "=" __FUNCDNAME__)
+ *     *Result = nullptr;
+ *     return ERROR_ACCESS_DENIED;
+ * }
+ *
+ * // Test host
+ * ffmock::reload::Binding<Mocks::FFRegOpenKeyW> open(library, "Mock_RegOpenKeyW");
+ * @endcode
+ */
+template<typename Mock_t>
+class Binding : private Bindable
+{
+    using Ret_t = typename Mock_t::Ret_t;
+    using Ptr_t = typename Mock_t::Ptr_t;
+
+public:
+    /**
+     * @brief Construct a new Binding object, setting the mock
+     *
+     * @param Source - The library
+     * @param Export - Name of the function exported by the library
+     */
+    Binding(Library& Source, const char* Export)
+        : Owner(Source)
+        , Name(Export)
+        , Set(std::ref(*this))
+    {
+        Owner.Attach(*this);
+    }
+
+    /**
+     * @brief Destroy the Binding object once the calls in the library returned
+     */
+    ~Binding(void)
+    {
+        Owner.Detach(*this);
+    }
+
+    Binding(Binding const&) = delete;
+    Binding& operator=(Binding const&) = delete;
+
+    /**
+     * @brief Check if the library exports the function
+     */
+    bool Bound(void) const
+    {
+        return Target.load(std::memory_order_acquire) != nullptr;
+    }
+
+    /**
+     * @brief Mock implementation calling the library
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Value returned by the library's function
+     */
+    template<typename... Args_t>
+    Ret_t operator()(Args_t... Args)
+    {
+        Library::Call call(Owner);
+        const Ptr_t target{Target.load(std::memory_order_acquire)};
+        if (!target)
+        {
+            return Mock_t::Real(Args...);
+        }
+        return target(Args...);
+    }
+
+private:
+    void Rebind(HMODULE Module) override
+    {
+        Target.store(Module ? reinterpret_cast<Ptr_t>(GetProcAddress(Module, Name)) : nullptr,
+                     std::memory_order_release);
+    }
+
+    Library& Owner;
+    const char* const Name;
+    std::atomic<Ptr_t> Target{};
+    typename Mock_t::Guard Set;
+};
+
+} // namespace reload
+} // namespace ffmock
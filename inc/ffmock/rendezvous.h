@@ -0,0 +1,310 @@
+/**
+  @brief Rendezvous mocks
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <processthreadsapi.h>
+#include <synchapi.h>
+#include <sysinfoapi.h>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace ffmock
+{
+
+/**
+ * @brief Mock behavior parking the calling thread until the test releases it
+ *
+ * @details Each call to the mocked API takes a free slot, publishes its arguments
+ *          and blocks on WaitOnAddress(). The test waits for arrivals with Wait()
+ *          and resumes the caller with Call::Release(). Up to Slots_k calls can be
+ *          parked at once; further callers block until a slot is freed.
+ *          The rendezvous sets the mock for its lifetime with its own Guard, so
+ *          the calls in flight are drained before it is destroyed.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ * @tparam Slots_k - Maximum number of parked calls
+ * @example
+ * @code {.cpp}
+ * ffmock::Rendezvous<Mocks::FFRegOpenKeyW> rendezvous;
+ *
+ * std::thread worker([]{ Registry().Open(L"Software\\Microsoft"); });
+ * auto call = rendezvous.Wait();
+ * EXPECT_STREQ(call->Arg<1>(), L"Software\\Microsoft");
+ * call->Release(ERROR_ACCESS_DENIED);
+ * worker.join();
+ * @endcode
+ */
+template<typename Mock_t, size_t Slots_k = 16>
+class Rendezvous
+{
+    using Ret_t = typename Mock_t::Ret_t;
+    using Tuple_t = typename Mock_t::Tuple_t;
+
+    /**
+     * @brief Life cycle of a slot
+     */
+    enum Phase : LONG
+    {
+        Free,       //!< Available to callers
+        Claimed,    //!< Caller is storing its arguments
+        Parked,     //!< Caller is waiting for the test
+        Taken,      //!< Returned by Wait() to the test
+        Released    //!< Caller may resume
+    };
+
+public:
+    /**
+     * @brief Parked call of the mocked API
+     */
+    class Call
+    {
+    public:
+        /**
+         * @brief Argument passed by the caller
+         *
+         * @tparam Index - Zero based position of the argument
+         */
+        template<size_t Index>
+        decltype(auto) Arg(void) const
+        {
+            return std::get<Index>(Arguments);
+        }
+
+        /**
+         * @brief All arguments passed by the caller
+         */
+        Tuple_t const& Args(void) const
+        {
+            return Arguments;
+        }
+
+        /**
+         * @brief Resume the caller returning the given value
+         *
+         * @param Value - Value returned by the mocked API
+         * @param Error - Last error to set (optional)
+         */
+        void Release(Ret_t Value, DWORD Error = NO_ERROR)
+        {
+            Result = Value;
+            LastError = Error;
+            Forward = false;
+            Resume();
+        }
+
+        /**
+         * @brief Resume the caller passing the call to the real API
+         */
+        void Release(void)
+        {
+            Forward = true;
+            Resume();
+        }
+
+    private:
+        friend class Rendezvous;
+
+        void Resume(void)
+        {
+            State.store(Released, std::memory_order_release);
+            WakeByAddressSingle(&State);
+        }
+
+        std::atomic<LONG> State{Free};
+        Tuple_t Arguments{};
+        Ret_t Result{};
+        DWORD LastError{};
+        bool Forward{};
+    };
+
+    /**
+     * @brief Construct the Rendezvous object setting it as the mock
+     */
+    Rendezvous(void)
+        : Guard(std::ref(*this))
+    {
+    }
+
+    Rendezvous(Rendezvous const&) = delete;
+    Rendezvous& operator=(Rendezvous const&) = delete;
+
+    /**
+     * @brief Destroy the Rendezvous object failing calls still parked
+     *
+     * @details Calls arriving while the rendezvous is closing fail at once. Once
+     *          no call is inside the rendezvous, clearing the Guard waits for the
+     *          released callers to return from the mock.
+     */
+    ~Rendezvous(void)
+    {
+        Closing.store(true);
+        // Wake callers waiting for a free slot
+        Freed.fetch_add(1, std::memory_order_release);
+        WakeByAddressAll(&Freed);
+        while (Entered.load(std::memory_order_acquire))
+        {
+            for (Call& call : Calls)
+            {
+                LONG state{call.State.load(std::memory_order_acquire)};
+                if (state == Parked || state == Taken)
+                {
+                    call.Release(Mock_t::ErrorValue(), Mock_t::Error2Set_k);
+                }
+            }
+            // Callers about to park, or returning
+            SwitchToThread();
+        }
+        Guard.Clear();
+    }
+
+    /**
+     * @brief Wait for the next call to arrive
+     *
+     * @param Timeout - Time to wait in milliseconds (default to INFINITE)
+     *
+     * @return Call* - The parked call, or nullptr if none arrived in time
+     */
+    Call* Wait(DWORD Timeout = INFINITE)
+    {
+        const ULONGLONG deadline{GetTickCount64() + Timeout};
+        for (;;)
+        {
+            LONG arrivals{Arrivals.load(std::memory_order_acquire)};
+            for (Call& call : Calls)
+            {
+                LONG parked{Parked};
+                if (call.State.compare_exchange_strong(parked, Taken, std::memory_order_acquire))
+                {
+                    return &call;
+                }
+            }
+            DWORD remaining{INFINITE};
+            if (Timeout != INFINITE)
+            {
+                const ULONGLONG now{GetTickCount64()};
+                if (now >= deadline)
+                {
+                    return nullptr;
+                }
+                remaining = static_cast<DWORD>(deadline - now);
+            }
+            if (!WaitOnAddress(&Arrivals, &arrivals, sizeof(arrivals), remaining) &&
+                GetLastError() == ERROR_TIMEOUT)
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Mock implementation parking the caller
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Value passed to Call::Release()
+     */
+    template<typename... Args_t>
+    Ret_t operator()(Args_t... Args)
+    {
+        Entered.fetch_add(1);
+        Call* claimed{Closing.load() ? nullptr : Claim()};
+        if (!claimed)
+        {
+            Entered.fetch_sub(1, std::memory_order_release);
+            if constexpr (Mock_t::Error2Set_k != NO_ERROR)
+            {
+                SetLastError(Mock_t::Error2Set_k);
+            }
+            return Mock_t::ErrorValue();
+        }
+        Call& call{*claimed};
+        call.Arguments = Tuple_t(Args...);
+        call.State.store(Parked, std::memory_order_release);
+        Arrivals.fetch_add(1, std::memory_order_release);
+        WakeByAddressAll(&Arrivals);
+
+        LONG state;
+        while ((state = call.State.load(std::memory_order_acquire)) != Released)
+        {
+            WaitOnAddress(&call.State, &state, sizeof(state), INFINITE);
+        }
+
+        const bool forward{call.Forward};
+        const Ret_t result{call.Result};
+        const DWORD error{call.LastError};
+        call.State.store(Free, std::memory_order_release);
+        Freed.fetch_add(1, std::memory_order_release);
+        WakeByAddressAll(&Freed);
+        Entered.fetch_sub(1, std::memory_order_release);
+
+        if (forward)
+        {
+            return Mock_t::Real(Args...);
+        }
+        if (error)
+        {
+            SetLastError(error);
+        }
+        return result;
+    }
+
+private:
+    Call* Claim(void)
+    {
+        for (;;)
+        {
+            LONG freed{Freed.load(std::memory_order_acquire)};
+            if (Closing.load())
+            {
+                return nullptr;
+            }
+            for (Call& call : Calls)
+            {
+                LONG vacant{Free};
+                if (call.State.compare_exchange_strong(vacant, Claimed, std::memory_order_acquire))
+                {
+                    return &call;
+                }
+            }
+            WaitOnAddress(&Freed, &freed, sizeof(freed), INFINITE);
+        }
+    }
+
+    Call Calls[Slots_k];
+    //! @brief Bumped when a call is parked
+    std::atomic<LONG> Arrivals{};
+    //! @brief Bumped when a slot is freed
+    std::atomic<LONG> Freed{};
+    //! @brief Number of calls inside the rendezvous
+    std::atomic<LONG> Entered{};
+    //! @brief Set by the destructor, so new calls fail instead of parking
+    std::atomic<bool> Closing{};
+    //! @brief Set last, so the mock is only called once the members are constructed
+    typename Mock_t::Guard Guard;
+};
+
+} // namespace ffmock
@@ -0,0 +1,192 @@
+/**
+  @brief Scripted mocks
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <array>
+
+namespace ffmock
+{
+
+/**
+ * @brief Function writing the out parameters of a call
+ */
+template<typename Tuple_t>
+struct Writer;
+
+template<typename... Args_t>
+struct Writer<std::tuple<Args_t...>>
+{
+    using Ptr_t = void(*)(Args_t...);
+};
+
+/**
+ * @brief Response to a single call of a scripted mock
+ *
+ * @details Steps are literal types, so scripts can be built at compile time.
+ *          Captureless lambdas convert to the Out function pointer.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ */
+template<typename Mock_t>
+struct Step
+{
+    using Ret_t = typename Mock_t::Ret_t;
+    using Out_t = typename Writer<typename Mock_t::Tuple_t>::Ptr_t;
+
+    Ret_t Value{};          //!< Value returned by the API
+    DWORD Error{NO_ERROR};  //!< Last error to set (as Error2Set)
+    Out_t Out{};            //!< Writes the out parameters (optional)
+    bool Forward{};         //!< Pass the call to the real API
+
+    /**
+     * @brief Step passing the call to the real API
+     */
+    static constexpr Step Real(void)
+    {
+        return Step{Ret_t{}, NO_ERROR, nullptr, true};
+    }
+};
+
+/**
+ * @brief What a script does once all its steps were taken
+ */
+enum class Exhausted
+{
+    Repeat, //!< Repeat the last step
+    Cycle,  //!< Start over from the first step
+    Real    //!< Pass the calls to the real API
+};
+
+/**
+ * @brief Mock behavior responding to successive calls with a fixed sequence of steps
+ *
+ * @details The steps are immutable. Each call takes the next step with a single
+ *          atomic increment of the cursor, so concurrent callers each get a distinct
+ *          step. Taking a step neither locks nor allocates.
+ *
+ * @tparam Mock_t - The mock class (e.g., Mocks::FFRegOpenKeyW)
+ * @tparam Steps_k - Number of steps
+ * @example
+ * @code {.cpp}
+ * using Step = ffmock::Step<Mocks::FFRegOpenKeyW>;
+ * static constexpr std::array<Step, 4> steps{{
+ *     Step::Real(), Step::Real(), {ERROR_REGISTRY_IO_FAILED}, Step::Real()}};
+ *
+ * ffmock::Script script(steps);
+ * Mocks::FFRegOpenKeyW::Guard guard(std::ref(script));
+ * @endcode
+ */
+template<typename Mock_t, size_t Steps_k>
+class Script
+{
+    using Ret_t = typename Mock_t::Ret_t;
+
+public:
+    using Step_t = Step<Mock_t>;
+
+    explicit Script(std::array<Step_t, Steps_k> const& Sequence, Exhausted Then = Exhausted::Repeat)
+        : Steps(Sequence)
+        , End(Then)
+    {
+        static_assert(Steps_k > 0, "A script must have at least one step");
+    }
+
+    Script(Script const&) = delete;
+    Script& operator=(Script const&) = delete;
+
+    /**
+     * @brief Number of calls taken by the script
+     */
+    ULONGLONG Taken(void) const
+    {
+        return Cursor.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check if all the steps were taken
+     */
+    bool Done(void) const
+    {
+        return Taken() >= Steps_k;
+    }
+
+    /**
+     * @brief Start over from the first step
+     */
+    void Rewind(void)
+    {
+        Cursor.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Mock implementation taking the next step
+     *
+     * @tparam Args_t - Arguments pack of the API
+     *
+     * @param Args - API arguments
+     * @return Ret_t - Value of the step
+     */
+    template<typename... Args_t>
+    Ret_t operator()(Args_t... Args)
+    {
+        ULONGLONG index{Cursor.fetch_add(1, std::memory_order_relaxed)};
+        if (index >= Steps_k)
+        {
+            if (End == Exhausted::Real)
+            {
+                return Mock_t::Real(Args...);
+            }
+            index = End == Exhausted::Cycle ? index % Steps_k : Steps_k - 1;
+        }
+        Step_t const& step{Steps[size_t(index)]};
+        if (step.Forward)
+        {
+            return Mock_t::Real(Args...);
+        }
+        if (step.Out)
+        {
+            step.Out(Args...);
+        }
+        if (step.Error)
+        {
+            SetLastError(step.Error);
+        }
+        return step.Value;
+    }
+
+private:
+    const std::array<Step_t, Steps_k> Steps;
+    const Exhausted End;
+    std::atomic<ULONGLONG> Cursor{};
+};
+
+template<typename Mock_t, size_t Steps_k>
+Script(std::array<Step<Mock_t>, Steps_k> const&) -> Script<Mock_t, Steps_k>;
+
+template<typename Mock_t, size_t Steps_k>
+Script(std::array<Step<Mock_t>, Steps_k> const&, Exhausted) -> Script<Mock_t, Steps_k>;
+
+} // namespace ffmock
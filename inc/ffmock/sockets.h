@@ -0,0 +1,918 @@
+/**
+  @brief In-memory sockets
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <winsock2.h>
+#include <ws2ipdef.h>
+#include <ffmock/ffmock.h>
+#include <ffmock/handles.h>
+#include <synchapi.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace ffmock
+{
+namespace sockets
+{
+
+//! @brief Maximum number of open sockets
+constexpr ULONG Slots_k = 1024;
+//! @brief First port assigned to sockets bound to port 0
+constexpr USHORT Ephemeral_k = 49152;
+
+/**
+ * @brief Model of one direction of a connection
+ *
+ * @details Times are in virtual microseconds.
+ */
+struct Link
+{
+    ULONGLONG Bandwidth{};          //!< Bytes per virtual second, 0 for unlimited
+    ULONGLONG Latency{};            //!< One way delay
+    ULONG Loss{};                   //!< Percent of the sends lost and retransmitted
+    ULONGLONG Retransmit{200000};   //!< Delay added to a lost send
+    ULONG Capacity{64 * 1024};      //!< Bytes buffered before send blocks (rounded up to a power of 2)
+};
+
+/**
+ * @brief In-process TCP network
+ *
+ * @details Each connection is a pair of ring buffers, one per direction. Send copies
+ *          straight from the caller's buffer into the ring, and recv from the ring into
+ *          the caller's buffer, so a message is copied twice and never allocated.
+ *          Each send is stamped with the virtual time it is delivered at, from the
+ *          bandwidth, latency and loss of the link. A lost send is retransmitted,
+ *          delaying the data after it as well.
+ *          All sockets are on a single host, so listeners are identified by port only.
+ *          With AutoAdvance, a blocking call waiting for data in flight moves the clock
+ *          to its delivery time, so no real time passes.
+ *
+ * @note Connect completes at once, also on non-blocking sockets.
+ */
+class Network
+{
+public:
+    /**
+     * @brief Construct a new Network object
+     *
+     * @param Defaults - Model of the connections without a shaped port
+     * @param Seed - Seed of the random losses
+     * @param AutoAdvance - Advance the clock when a caller waits for data
+     */
+    explicit Network(Link Defaults = Link{}, ULONG Seed = 1, bool AutoAdvance = true)
+        : Model(Defaults)
+        , Random(Seed)
+        , Automatic(AutoAdvance)
+    {
+        Free.reserve(Slots_k);
+        for (ULONG slot = Slots_k; slot; --slot)
+        {
+            Free.push_back(slot - 1);
+        }
+    }
+
+    Network(Network const&) = delete;
+    Network& operator=(Network const&) = delete;
+
+    /*************************************************************
+     * @brief Test helpers
+     *************************************************************/
+
+    /**
+     * @brief Set the model of new connections to a port
+     *
+     * @param Listener - Port of the listener (host byte order)
+     * @param Connections - Model of both directions
+     */
+    void Shape(USHORT Listener, Link const& Connections)
+    {
+        Exclusive lock(Lock);
+        Shapes[Swap(Listener)] = Connections;
+    }
+
+    /**
+     * @brief Virtual time in microseconds
+     */
+    ULONGLONG Now(void) const
+    {
+        return Clock.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Advance the clock, delivering the data which arrives meanwhile
+     *
+     * @param Time - Virtual microseconds to advance
+     */
+    void Advance(ULONGLONG Time)
+    {
+        Clock.fetch_add(Time, std::memory_order_acq_rel);
+        Notify();
+    }
+
+    /*************************************************************
+     * @brief API implementations
+     *
+     * @details Failures return SOCKET_ERROR (or INVALID_SOCKET)
+     *          and set the last error, like Winsock.
+     *************************************************************/
+
+    /**
+     * @brief Check if the socket belongs to the network
+     */
+    static bool Owns(SOCKET Socket)
+    {
+        return handles::Is(reinterpret_cast<HANDLE>(Socket), handles::Kind::Socket);
+    }
+
+    /**
+     * @brief socket() semantics for SOCK_STREAM sockets
+     */
+    SOCKET Create(int Family)
+    {
+        Exclusive lock(Lock);
+        if (Free.empty())
+        {
+            SetLastError(WSAEMFILE);
+            return INVALID_SOCKET;
+        }
+        const ULONG slot{Free.back()};
+        Free.pop_back();
+        Sockets[slot] = std::make_shared<Endpoint>();
+        Sockets[slot]->Family = Family;
+        return reinterpret_cast<SOCKET>(handles::Make(handles::Kind::Socket, slot));
+    }
+
+    /**
+     * @brief bind() semantics, port 0 picks an ephemeral port
+     */
+    int Bind(SOCKET Socket, const sockaddr* Address, int Length)
+    {
+        Exclusive lock(Lock);
+        Endpoint* endpoint{Get(Socket)};
+        if (!endpoint)
+        {
+            return Fail(WSAENOTSOCK);
+        }
+        if (!Address || Length < int(sizeof(sockaddr_in)))
+        {
+            return Fail(WSAEFAULT);
+        }
+        if (endpoint->Port)
+        {
+            return Fail(WSAEINVAL);
+        }
+        USHORT port{Port(Address)};
+        if (!port)
+        {
+            port = NextPort();
+        }
+        else if (Listeners.count(port))
+        {
+            return Fail(WSAEADDRINUSE);
+        }
+        endpoint->Port = port;
+        return 0;
+    }
+
+    /**
+     * @brief listen() semantics
+     */
+    int Listen(SOCKET Socket, int Backlog)
+    {
+        Exclusive lock(Lock);
+        Endpoint* endpoint{Get(Socket)};
+        if (!endpoint)
+        {
+            return Fail(WSAENOTSOCK);
+        }
+        if (!endpoint->Port || endpoint->In)
+        {
+            return Fail(WSAEINVAL);
+        }
+        if (!endpoint->Listening)
+        {
+            if (Listeners.count(endpoint->Port))
+            {
+                return Fail(WSAEADDRINUSE);
+            }
+            Listeners[endpoint->Port] = Sockets[Slot(Socket)];
+            endpoint->Listening = true;
+        }
+        endpoint->Limit = Backlog == SOMAXCONN || Backlog <= 0 ? INT_MAX : Backlog;
+        return 0;
+    }
+
+    /**
+     * @brief accept() semantics
+     */
+    SOCKET Accept(SOCKET Socket, sockaddr* Address, int* Length)
+    {
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            {
+                Exclusive lock(Lock);
+                Endpoint* endpoint{Get(Socket)};
+                if (!endpoint || !endpoint->Listening)
+                {
+                    Fail(endpoint ? WSAEINVAL : WSAENOTSOCK);
+                    return INVALID_SOCKET;
+                }
+                if (!endpoint->Backlog.empty())
+                {
+                    if (Free.empty())
+                    {
+                        Fail(WSAEMFILE);
+                        return INVALID_SOCKET;
+                    }
+                    const ULONG slot{Free.back()};
+                    Free.pop_back();
+                    Sockets[slot] = endpoint->Backlog.front();
+                    endpoint->Backlog.pop_front();
+                    if (Address && Length && *Length >= int(sizeof(sockaddr_in)))
+                    {
+                        // Address of the peer on the loopback interface
+                        memset(Address, 0, *Length);
+                        sockaddr_in* peer{reinterpret_cast<sockaddr_in*>(Address)};
+                        peer->sin_family = AF_INET;
+                        peer->sin_port = Sockets[slot]->Peer;
+                        peer->sin_addr.s_addr = Swap32(INADDR_LOOPBACK);
+                        *Length = int(sizeof(sockaddr_in));
+                    }
+                    return reinterpret_cast<SOCKET>(handles::Make(handles::Kind::Socket, slot));
+                }
+                if (endpoint->NonBlocking)
+                {
+                    Fail(WSAEWOULDBLOCK);
+                    return INVALID_SOCKET;
+                }
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+    }
+
+    /**
+     * @brief connect() semantics
+     */
+    int Connect(SOCKET Socket, const sockaddr* Address, int Length)
+    {
+        {
+            Exclusive lock(Lock);
+            Endpoint* endpoint{Get(Socket)};
+            if (!endpoint)
+            {
+                return Fail(WSAENOTSOCK);
+            }
+            if (!Address || Length < int(sizeof(sockaddr_in)))
+            {
+                return Fail(WSAEFAULT);
+            }
+            if (endpoint->Listening)
+            {
+                return Fail(WSAEINVAL);
+            }
+            if (endpoint->In)
+            {
+                return Fail(WSAEISCONN);
+            }
+            auto listener = Listeners.find(Port(Address));
+            if (listener == Listeners.end() ||
+                listener->second->Backlog.size() >= size_t(listener->second->Limit))
+            {
+                return Fail(WSAECONNREFUSED);
+            }
+            auto shape = Shapes.find(listener->first);
+            Link const& model{shape != Shapes.end() ? shape->second : Model};
+            if (!endpoint->Port)
+            {
+                endpoint->Port = NextPort();
+            }
+            std::shared_ptr<Endpoint> accepted{std::make_shared<Endpoint>()};
+            accepted->Family = listener->second->Family;
+            accepted->Port = listener->first;
+            accepted->Peer = endpoint->Port;
+            accepted->In = endpoint->Out = std::make_shared<Pipe>(model);
+            accepted->Out = endpoint->In = std::make_shared<Pipe>(model);
+            endpoint->Peer = listener->first;
+            listener->second->Backlog.push_back(std::move(accepted));
+        }
+        Notify();
+        return 0;
+    }
+
+    /**
+     * @brief send() semantics
+     *
+     * @details A blocking send returns once all the data is buffered,
+     *          a non-blocking send buffers as much as fits.
+     */
+    int Send(SOCKET Socket, const char* Buffer, int Size, int)
+    {
+        if (Size < 0)
+        {
+            return Fail(WSAEINVAL);
+        }
+        int sent{};
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            {
+                Exclusive lock(Lock);
+                Endpoint* endpoint{Get(Socket)};
+                if (!endpoint)
+                {
+                    return Fail(WSAENOTSOCK);
+                }
+                if (!endpoint->Out)
+                {
+                    return Fail(WSAENOTCONN);
+                }
+                Pipe& pipe{*endpoint->Out};
+                if (pipe.Abandoned)
+                {
+                    return Fail(WSAECONNRESET);
+                }
+                if (pipe.Closed)
+                {
+                    return Fail(WSAESHUTDOWN);
+                }
+                sent += Write(pipe, Buffer + sent, size_t(Size - sent));
+                if (sent == Size || endpoint->NonBlocking)
+                {
+                    break;
+                }
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+        if (!sent && Size)
+        {
+            return Fail(WSAEWOULDBLOCK);
+        }
+        Notify();
+        return sent;
+    }
+
+    /**
+     * @brief recv() semantics, with MSG_PEEK
+     *
+     * @return int - Number of bytes received, 0 once the peer closed and all data was received
+     */
+    int Recv(SOCKET Socket, char* Buffer, int Size, int Flags)
+    {
+        if (Size < 0)
+        {
+            return Fail(WSAEINVAL);
+        }
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            ULONGLONG next{};
+            int received{-1};
+            {
+                Exclusive lock(Lock);
+                Endpoint* endpoint{Get(Socket)};
+                if (!endpoint)
+                {
+                    return Fail(WSAENOTSOCK);
+                }
+                if (!endpoint->In)
+                {
+                    return Fail(WSAENOTCONN);
+                }
+                Pipe& pipe{*endpoint->In};
+                Deliver(pipe);
+                if (pipe.Visible > pipe.Read || !Size)
+                {
+                    received = int(Read(pipe, Buffer, size_t(Size), !(Flags & MSG_PEEK)));
+                }
+                else if (pipe.Closed && pipe.Segments.empty())
+                {
+                    return 0;
+                }
+                else if (endpoint->NonBlocking)
+                {
+                    return Fail(WSAEWOULDBLOCK);
+                }
+                else if (Automatic && !pipe.Segments.empty())
+                {
+                    next = pipe.Segments.front().Ready;
+                }
+            }
+            if (received >= 0)
+            {
+                if (!(Flags & MSG_PEEK))
+                {
+                    // Release blocked senders
+                    Notify();
+                }
+                return received;
+            }
+            if (next)
+            {
+                AdvanceTo(next);
+                continue;
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+    }
+
+    /**
+     * @brief closesocket() semantics
+     *
+     * @details The peer receives the data already sent, then end of stream.
+     */
+    int Close(SOCKET Socket)
+    {
+        {
+            Exclusive lock(Lock);
+            Endpoint* endpoint{Get(Socket)};
+            if (!endpoint)
+            {
+                return Fail(WSAENOTSOCK);
+            }
+            if (endpoint->Listening)
+            {
+                Listeners.erase(endpoint->Port);
+                for (std::shared_ptr<Endpoint> const& pending : endpoint->Backlog)
+                {
+                    Disconnect(*pending);
+                }
+            }
+            Disconnect(*endpoint);
+            Sockets[Slot(Socket)].reset();
+            Free.push_back(Slot(Socket));
+        }
+        Notify();
+        return 0;
+    }
+
+    /**
+     * @brief ioctlsocket() semantics for FIONBIO and FIONREAD
+     */
+    int Control(SOCKET Socket, long Command, u_long* Argument)
+    {
+        Exclusive lock(Lock);
+        Endpoint* endpoint{Get(Socket)};
+        if (!endpoint)
+        {
+            return Fail(WSAENOTSOCK);
+        }
+        if (!Argument)
+        {
+            return Fail(WSAEFAULT);
+        }
+        if (Command == long(FIONBIO))
+        {
+            endpoint->NonBlocking = *Argument != 0;
+            return 0;
+        }
+        if (Command == long(FIONREAD))
+        {
+            *Argument = 0;
+            if (endpoint->In)
+            {
+                Deliver(*endpoint->In);
+                *Argument = u_long((std::min)(endpoint->In->Visible - endpoint->In->Read, ULONGLONG(ULONG_MAX)));
+            }
+            return 0;
+        }
+        return Fail(WSAEINVAL);
+    }
+
+    /**
+     * @brief WSAPoll() semantics, with Timeout in virtual milliseconds
+     *
+     * @details All the polled sockets must belong to the network,
+     *          a mixed array fails with WSAEINVAL.
+     */
+    int Poll(LPWSAPOLLFD Polled, ULONG Count, INT Timeout)
+    {
+        for (ULONG index = 0; index < Count; ++index)
+        {
+            if (!Owns(Polled[index].fd))
+            {
+                return Fail(WSAEINVAL);
+            }
+        }
+        const ULONGLONG deadline{Timeout < 0 ? ULLONG_MAX : Now() + ULONGLONG(Timeout) * 1000};
+        for (;;)
+        {
+            LONG signal{Signal.load(std::memory_order_acquire)};
+            ULONGLONG next{ULLONG_MAX};
+            int ready{};
+            {
+                Exclusive lock(Lock);
+                for (ULONG index = 0; index < Count; ++index)
+                {
+                    WSAPOLLFD& poll{Polled[index]};
+                    poll.revents = SHORT(Events(poll.fd, next) & (poll.events | POLLERR | POLLHUP | POLLNVAL));
+                    ready += poll.revents ? 1 : 0;
+                }
+            }
+            if (ready || !Timeout)
+            {
+                return ready;
+            }
+            if (Automatic)
+            {
+                // With nothing in flight, only another thread can make a socket ready
+                if (next != ULLONG_MAX && next <= deadline)
+                {
+                    AdvanceTo(next);
+                    continue;
+                }
+                if (deadline != ULLONG_MAX)
+                {
+                    AdvanceTo(deadline);
+                    return 0;
+                }
+            }
+            else if (Now() >= deadline)
+            {
+                return 0;
+            }
+            WaitOnAddress(&Signal, &signal, sizeof(signal), INFINITE);
+        }
+    }
+
+private:
+    //! @brief Data of a send, delivered at a virtual time
+    struct Segment
+    {
+        ULONGLONG End;      //!< Stream offset after the data
+        ULONGLONG Ready;    //!< Delivery time
+    };
+
+    /**
+     * @brief One direction of a connection
+     */
+    struct Pipe
+    {
+        explicit Pipe(Link const& Connection)
+            : Model(Connection)
+        {
+            size_t capacity{1};
+            while (capacity < Connection.Capacity)
+            {
+                capacity <<= 1;
+            }
+            Ring.resize(capacity);
+        }
+
+        const Link Model;
+        std::vector<char> Ring;
+        ULONGLONG Read{};       //!< Bytes received
+        ULONGLONG Visible{};    //!< Bytes delivered
+        ULONGLONG Written{};    //!< Bytes sent
+        ULONGLONG Busy{};       //!< Time the link is busy until
+        std::deque<Segment> Segments;
+        bool Closed{};          //!< The sender closed
+        bool Abandoned{};       //!< The receiver closed
+    };
+
+    struct Endpoint
+    {
+        int Family{};
+        USHORT Port{};          //!< Local port (network byte order)
+        USHORT Peer{};          //!< Remote port (network byte order)
+        bool Listening{};
+        bool NonBlocking{};
+        int Limit{};
+        std::shared_ptr<Pipe> In;
+        std::shared_ptr<Pipe> Out;
+        std::deque<std::shared_ptr<Endpoint>> Backlog;
+    };
+
+    //! @brief Scoped lock of the network, which SRW lock API mocks must not profile or schedule
+    using Exclusive = std::lock_guard<std::mutex>;
+
+    static USHORT Swap(USHORT Value)
+    {
+        return USHORT((Value << 8) | (Value >> 8));
+    }
+
+    static ULONG Swap32(ULONG Value)
+    {
+        return (Value << 24) | ((Value << 8) & 0xFF0000) | ((Value >> 8) & 0xFF00) | (Value >> 24);
+    }
+
+    //! @brief Port of an IPv4 or IPv6 address (same offset in both)
+    static USHORT Port(const sockaddr* Address)
+    {
+        return reinterpret_cast<const sockaddr_in*>(Address)->sin_port;
+    }
+
+    static ULONG Slot(SOCKET Socket)
+    {
+        return handles::Slot(reinterpret_cast<HANDLE>(Socket));
+    }
+
+    static int Fail(int Error)
+    {
+        SetLastError(DWORD(Error));
+        return SOCKET_ERROR;
+    }
+
+    //! @brief Endpoint of a socket (requires the lock)
+    Endpoint* Get(SOCKET Socket) const
+    {
+        return Owns(Socket) && Slot(Socket) < Slots_k ? Sockets[Slot(Socket)].get() : nullptr;
+    }
+
+    //! @brief Unused ephemeral port (requires the lock)
+    USHORT NextPort(void)
+    {
+        USHORT port;
+        do
+        {
+            port = Swap(Ephemeral++);
+            if (!Ephemeral)
+            {
+                Ephemeral = Ephemeral_k;
+            }
+        } while (Listeners.count(port));
+        return port;
+    }
+
+    /**
+     * @brief Buffer data and stamp its delivery time (requires the lock)
+     *
+     * @return size_t - Number of bytes which fit in the ring
+     */
+    size_t Write(Pipe& Target, const char* Buffer, size_t Size)
+    {
+        const size_t capacity{Target.Ring.size()};
+        const size_t count{(std::min)(Size, size_t(capacity - (Target.Written - Target.Read)))};
+        if (!count)
+        {
+            return 0;
+        }
+        const size_t offset{size_t(Target.Written & (capacity - 1))};
+        const size_t first{(std::min)(count, capacity - offset)};
+        memcpy(&Target.Ring[offset], Buffer, first);
+        memcpy(&Target.Ring[0], Buffer + first, count - first);
+
+        Link const& model{Target.Model};
+        const ULONGLONG transmit{model.Bandwidth ? (ULONGLONG(count) * 1000000 + model.Bandwidth - 1) / model.Bandwidth : 0};
+        Target.Busy = (std::max)(Target.Busy, Now()) + transmit;
+        ULONGLONG ready{Target.Busy + model.Latency};
+        if (model.Loss && Random() % 100 < model.Loss)
+        {
+            ready += model.Retransmit;
+        }
+        if (!Target.Segments.empty())
+        {
+            // Data is delivered in order
+            ready = (std::max)(ready, Target.Segments.back().Ready);
+        }
+        Target.Written += count;
+        Target.Segments.push_back(Segment{Target.Written, ready});
+        return count;
+    }
+
+    /**
+     * @brief Copy delivered data out of the ring (requires the lock)
+     */
+    static size_t Read(Pipe& Source, char* Buffer, size_t Size, bool Consume)
+    {
+        const size_t capacity{Source.Ring.size()};
+        const size_t count{size_t((std::min)(ULONGLONG(Size), Source.Visible - Source.Read))};
+        const size_t offset{size_t(Source.Read & (capacity - 1))};
+        const size_t first{(std::min)(count, capacity - offset)};
+        memcpy(Buffer, &Source.Ring[offset], first);
+        memcpy(Buffer + first, &Source.Ring[0], count - first);
+        if (Consume)
+        {
+            Source.Read += count;
+        }
+        return count;
+    }
+
+    //! @brief Make the data due by now visible (requires the lock)
+    void Deliver(Pipe& Source) const
+    {
+        const ULONGLONG now{Now()};
+        while (!Source.Segments.empty() && Source.Segments.front().Ready <= now)
+        {
+            Source.Visible = Source.Segments.front().End;
+            Source.Segments.pop_front();
+        }
+    }
+
+    //! @brief Close both directions of an endpoint (requires the lock)
+    static void Disconnect(Endpoint& Closed)
+    {
+        if (Closed.Out)
+        {
+            Closed.Out->Closed = true;
+        }
+        if (Closed.In)
+        {
+            Closed.In->Abandoned = true;
+        }
+    }
+
+    /**
+     * @brief Poll events of a socket (requires the lock)
+     *
+     * @param Socket - The socket
+     * @param Next - Updated with the earliest delivery time of data in flight
+     */
+    int Events(SOCKET Socket, ULONGLONG& Next) const
+    {
+        Endpoint* endpoint{Get(Socket)};
+        if (!endpoint)
+        {
+            return POLLNVAL;
+        }
+        if (endpoint->Listening)
+        {
+            return endpoint->Backlog.empty() ? 0 : POLLRDNORM;
+        }
+        int events{};
+        if (Pipe* in{endpoint->In.get()})
+        {
+            Deliver(*in);
+            if (in->Visible > in->Read)
+            {
+                events |= POLLRDNORM;
+            }
+            else if (in->Closed && in->Segments.empty())
+            {
+                events |= POLLHUP;
+            }
+            if (!in->Segments.empty())
+            {
+                Next = (std::min)(Next, in->Segments.front().Ready);
+            }
+        }
+        if (Pipe* out{endpoint->Out.get()})
+        {
+            if (out->Abandoned)
+            {
+                events |= POLLHUP;
+            }
+            else if (out->Written - out->Read < out->Ring.size())
+            {
+                events |= POLLWRNORM;
+            }
+        }
+        return events;
+    }
+
+    void AdvanceTo(ULONGLONG Time)
+    {
+        ULONGLONG now{Clock.load(std::memory_order_acquire)};
+        while (now < Time && !Clock.compare_exchange_weak(now, Time, std::memory_order_acq_rel))
+        {
+        }
+        Notify();
+    }
+
+    void Notify(void)
+    {
+        Signal.fetch_add(1, std::memory_order_release);
+        WakeByAddressAll(&Signal);
+    }
+
+    const Link Model;
+    std::mt19937 Random;
+    const bool Automatic;
+    mutable std::mutex Lock;
+    std::atomic<ULONGLONG> Clock{};
+    //! @brief Bumped on every change a blocked caller may wait for
+    std::atomic<LONG> Signal{};
+    USHORT Ephemeral{Ephemeral_k};
+    std::shared_ptr<Endpoint> Sockets[Slots_k];
+    std::vector<ULONG> Free;
+    std::unordered_map<USHORT, std::shared_ptr<Endpoint>> Listeners;
+    std::unordered_map<USHORT, Link> Shapes;
+};
+
+/**
+ * @brief Redirect the socket APIs mocks to an in-process network
+ *
+ * @details Stream sockets created while mounted belong to the network.
+ *          Other sockets are passed to the real APIs.
+ *
+ * @tparam socket_t - Mock class of socket()
+ * @tparam bind_t - Mock class of bind()
+ * @tparam listen_t - Mock class of listen()
+ * @tparam accept_t - Mock class of accept()
+ * @tparam connect_t - Mock class of connect()
+ * @tparam send_t - Mock class of send()
+ * @tparam recv_t - Mock class of recv()
+ * @tparam closesocket_t - Mock class of closesocket()
+ * @tparam ioctlsocket_t - Mock class of ioctlsocket()
+ * @tparam WSAPoll_t - Mock class of WSAPoll()
+ */
+template<typename socket_t, typename bind_t, typename listen_t, typename accept_t, typename connect_t,
+         typename send_t, typename recv_t, typename closesocket_t, typename ioctlsocket_t, typename WSAPoll_t>
+class Mount
+{
+public:
+    explicit Mount(Network& Net)
+        : SocketGuard([&Net](int Family, int Type, int Protocol) -> SOCKET
+            {
+                return (Family == AF_INET || Family == AF_INET6) && Type == SOCK_STREAM &&
+                       (!Protocol || Protocol == IPPROTO_TCP) ? Net.Create(Family) :
+                       socket_t::Real(Family, Type, Protocol);
+            })
+        , BindGuard([&Net](SOCKET Socket, const sockaddr* Address, int Length) -> int
+            {
+                return Network::Owns(Socket) ? Net.Bind(Socket, Address, Length) :
+                       bind_t::Real(Socket, Address, Length);
+            })
+        , ListenGuard([&Net](SOCKET Socket, int Backlog) -> int
+            {
+                return Network::Owns(Socket) ? Net.Listen(Socket, Backlog) : listen_t::Real(Socket, Backlog);
+            })
+        , AcceptGuard([&Net](SOCKET Socket, sockaddr* Address, int* Length) -> SOCKET
+            {
+                return Network::Owns(Socket) ? Net.Accept(Socket, Address, Length) :
+                       accept_t::Real(Socket, Address, Length);
+            })
+        , ConnectGuard([&Net](SOCKET Socket, const sockaddr* Address, int Length) -> int
+            {
+                return Network::Owns(Socket) ? Net.Connect(Socket, Address, Length) :
+                       connect_t::Real(Socket, Address, Length);
+            })
+        , SendGuard([&Net](SOCKET Socket, const char* Buffer, int Size, int Flags) -> int
+            {
+                return Network::Owns(Socket) ? Net.Send(Socket, Buffer, Size, Flags) :
+                       send_t::Real(Socket, Buffer, Size, Flags);
+            })
+        , RecvGuard([&Net](SOCKET Socket, char* Buffer, int Size, int Flags) -> int
+            {
+                return Network::Owns(Socket) ? Net.Recv(Socket, Buffer, Size, Flags) :
+                       recv_t::Real(Socket, Buffer, Size, Flags);
+            })
+        , CloseGuard([&Net](SOCKET Socket) -> int
+            {
+                return Network::Owns(Socket) ? Net.Close(Socket) : closesocket_t::Real(Socket);
+            })
+        , ControlGuard([&Net](SOCKET Socket, long Command, u_long* Argument) -> int
+            {
+                return Network::Owns(Socket) ? Net.Control(Socket, Command, Argument) :
+                       ioctlsocket_t::Real(Socket, Command, Argument);
+            })
+        , PollGuard([&Net](LPWSAPOLLFD Polled, ULONG Count, INT Timeout) -> int
+            {
+                for (ULONG index = 0; index < Count; ++index)
+                {
+                    if (Network::Owns(Polled[index].fd))
+                    {
+                        return Net.Poll(Polled, Count, Timeout);
+                    }
+                }
+                return WSAPoll_t::Real(Polled, Count, Timeout);
+            })
+    {
+    }
+
+private:
+    typename socket_t::Guard SocketGuard;
+    typename bind_t::Guard BindGuard;
+    typename listen_t::Guard ListenGuard;
+    typename accept_t::Guard AcceptGuard;
+    typename connect_t::Guard ConnectGuard;
+    typename send_t::Guard SendGuard;
+    typename recv_t::Guard RecvGuard;
+    typename closesocket_t::Guard CloseGuard;
+    typename ioctlsocket_t::Guard ControlGuard;
+    typename WSAPoll_t::Guard PollGuard;
+};
+
+} // namespace sockets
+} // namespace ffmock
@@ -0,0 +1,454 @@
+/**
+  @brief Thread creation redirected to a worker pool
+  @author Uriel Mann
+  @copyright 2023-2024 Uriel Mann (abba.mann@gmail.com)
+
+:: Permission is hereby granted, free of charge, to any person obtaining a copy
+:: of this software and associated documentation files (the "Software"), to deal
+:: in the Software without restriction, including without limitation the rights
+:: to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+:: copies of the Software, and to permit persons to whom the Software is
+:: furnished to do so, subject to the following conditions:
+
+:: The above copyright notice and this permission notice shall be included in all
+:: copies or substantial portions of the Software.
+
+:: THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+:: IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+:: FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+:: AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+:: LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+:: OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+:: SOFTWARE.
+*/
+
+#pragma once
+
+#include <ffmock/ffmock.h>
+#include <handleapi.h>
+#include <processthreadsapi.h>
+#include <synchapi.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ffmock
+{
+namespace threads
+{
+
+//! @brief First identifier given to pooled threads (real identifiers are much lower)
+constexpr DWORD FirstId_k = 0x40000000;
+
+/**
+ * @brief Pool of reusable worker threads running the routines of mocked CreateThread() calls
+ *
+ * @details Each created thread is a manual reset event, signaled when its routine
+ *          returns. Waiting for it with WaitForSingleObject(), WaitForMultipleObjects()
+ *          and closing it with CloseHandle() work as for a real thread. Closing the
+ *          handle forgets the thread, and a handle value reused by another object
+ *          is not mistaken for a thread of the pool.
+ *          When no worker is idle, another one is spawned, so routines waiting for
+ *          each other never deadlock. Workers are kept for the next routines.
+ *          In serialized mode, a single worker runs the routines one at a time, in
+ *          the order they were created (or resumed, when created suspended).
+ *
+ * @note Routines must return rather than call ExitThread(), which ends the worker.
+ *       GetCurrentThreadId() in a routine returns the worker's identifier.
+ *       In serialized mode, a routine waiting for a thread created after it never returns.
+ */
+class Pool
+{
+public:
+    /**
+     * @brief Construct a new Pool object
+     *
+     * @param Workers - Number of workers spawned upfront (0 for one per processor)
+     * @param Serialized - Run the routines one at a time, in order
+     */
+    explicit Pool(ULONG Workers = 0, bool Serialized = false)
+        : Sequential(Serialized)
+    {
+        ULONG count{Sequential ? 1 : Workers ? Workers : (std::max)(std::thread::hardware_concurrency(), 1u)};
+        Exclusive lock(Lock);
+        while (count--)
+        {
+            Spawn();
+        }
+    }
+
+    Pool(Pool const&) = delete;
+    Pool& operator=(Pool const&) = delete;
+
+    /**
+     * @brief Destroy the Pool object after running the queued routines
+     *
+     * @details Threads still suspended never run; waiting for them returns at once.
+     */
+    ~Pool(void)
+    {
+        std::unordered_map<HANDLE, std::shared_ptr<Task>> threads;
+        {
+            Exclusive lock(Lock);
+            Stopping = true;
+        }
+        Queued.notify_all();
+        // Running routines may still spawn workers
+        for (size_t index = 0;; ++index)
+        {
+            std::thread worker;
+            {
+                Exclusive lock(Lock);
+                if (index == Workers.size())
+                {
+                    break;
+                }
+                worker = std::move(Workers[index]);
+            }
+            worker.join();
+        }
+        {
+            Exclusive lock(Lock);
+            threads.swap(Threads);
+        }
+        for (auto& entry : threads)
+        {
+            if (entry.second->Suspended)
+            {
+                SetEvent(entry.second->Done);
+            }
+        }
+    }
+
+    /*************************************************************
+     * @brief Test helpers
+     *************************************************************/
+
+    /**
+     * @brief Number of worker threads spawned so far
+     */
+    size_t Spawned(void) const
+    {
+        Exclusive lock(Lock);
+        return Workers.size();
+    }
+
+    /**
+     * @brief Number of routines which returned
+     */
+    ULONGLONG Completed(void) const
+    {
+        return Returned.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Wait until all the queued routines returned
+     */
+    void Drain(void)
+    {
+        Exclusive lock(Lock);
+        while (!Pending.empty() || Idle < Workers.size())
+        {
+            Drained.wait(lock);
+        }
+    }
+
+    /*************************************************************
+     * @brief API implementations
+     *************************************************************/
+
+    /**
+     * @brief Check if the handle is a thread created by the pool
+     */
+    bool Owns(HANDLE Thread) const
+    {
+        Exclusive lock(Lock);
+        return Find(Thread) != nullptr;
+    }
+
+    /**
+     * @brief CreateThread() semantics, with CREATE_SUSPENDED
+     *
+     * @return HANDLE - Handle signaled once the routine returns, or nullptr on failure
+     */
+    HANDLE Create(LPTHREAD_START_ROUTINE Routine, LPVOID Parameter, DWORD Flags, LPDWORD ThreadId)
+    {
+        HANDLE thread{CreateEventW(nullptr, TRUE, FALSE, nullptr)};
+        if (!thread)
+        {
+            return nullptr;
+        }
+        std::shared_ptr<Task> task{std::make_shared<Task>()};
+        task->Routine = Routine;
+        task->Parameter = Parameter;
+        task->Suspended = Flags & CREATE_SUSPENDED ? 1 : 0;
+        // The pool's own handle outlives the caller closing the thread's handle, and identifies it
+        if (!DuplicateHandle(GetCurrentProcess(), thread, GetCurrentProcess(), &task->Done,
+                             0, FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            const DWORD error{GetLastError()};
+            CloseHandle(thread);
+            SetLastError(error);
+            return nullptr;
+        }
+
+        // A thread whose handle was closed without Close() is replaced, and released unlocked
+        std::shared_ptr<Task> previous{task};
+        {
+            Exclusive lock(Lock);
+            task->Id = NextId;
+            NextId += 4;
+            Threads[thread].swap(previous);
+            if (ThreadId)
+            {
+                *ThreadId = task->Id;
+            }
+            if (!task->Suspended)
+            {
+                Queue(task);
+            }
+        }
+        return thread;
+    }
+
+    /**
+     * @brief CloseHandle() semantics for the pool's part of a thread's handle
+     *
+     * @details Forgets the thread, so the handle's value no longer belongs to the pool.
+     *          The caller still closes the handle itself. A suspended thread never runs.
+     *
+     * @return bool - true if the handle was a thread of the pool
+     */
+    bool Close(HANDLE Thread)
+    {
+        std::shared_ptr<Task> task;
+        {
+            Exclusive lock(Lock);
+            auto thread = Threads.find(Thread);
+            if (thread == Threads.end())
+            {
+                return false;
+            }
+            task.swap(thread->second);
+            Threads.erase(thread);
+        }
+        // The last reference closes the pool's handle, outside the lock
+        task.reset();
+        return true;
+    }
+
+    /**
+     * @brief ResumeThread() semantics
+     *
+     * @return DWORD - Previous suspend count
+     */
+    DWORD Resume(HANDLE Thread)
+    {
+        Exclusive lock(Lock);
+        std::shared_ptr<Task> const* task{Find(Thread)};
+        if (!task)
+        {
+            SetLastError(ERROR_INVALID_HANDLE);
+            return DWORD(-1);
+        }
+        const DWORD previous{(*task)->Suspended};
+        if (previous && !--(*task)->Suspended)
+        {
+            Queue(*task);
+        }
+        return previous;
+    }
+
+    /**
+     * @brief GetExitCodeThread() semantics
+     *
+     * @return BOOL - TRUE, with STILL_ACTIVE until the routine returns
+     */
+    BOOL ExitCode(HANDLE Thread, LPDWORD Code) const
+    {
+        Exclusive lock(Lock);
+        std::shared_ptr<Task> const* task{Find(Thread)};
+        if (!task || !Code)
+        {
+            SetLastError(!task ? ERROR_INVALID_HANDLE : ERROR_INVALID_PARAMETER);
+            return FALSE;
+        }
+        *Code = (*task)->Exit.load(std::memory_order_acquire);
+        return TRUE;
+    }
+
+private:
+    /**
+     * @brief Routine of a created thread
+     */
+    struct Task
+    {
+        ~Task(void)
+        {
+            if (Done)
+            {
+                CloseHandle(Done);
+            }
+        }
+
+        LPTHREAD_START_ROUTINE Routine{};
+        LPVOID Parameter{};
+        HANDLE Done{};                          //!< Pool's handle of the thread's event
+        DWORD Id{};
+        DWORD Suspended{};                      //!< Suspend count
+        std::atomic<DWORD> Exit{STILL_ACTIVE};
+    };
+
+    //! @brief Scoped lock of the pool (not an SRW lock, so the lock API mocks skip it)
+    using Exclusive = std::unique_lock<std::mutex>;
+
+    /**
+     * @brief Thread of a handle (requires the lock)
+     *
+     * @details A handle closed without Close() may have been reused for another object,
+     *          so the entry only matches while the handle still refers to the thread's event.
+     */
+    std::shared_ptr<Task> const* Find(HANDLE Thread) const
+    {
+        auto thread = Threads.find(Thread);
+        return thread != Threads.end() && Same(Thread, thread->second->Done) ? &thread->second : nullptr;
+    }
+
+    //! @brief Check if two handles refer to the same kernel object (always true before Windows 10)
+    static bool Same(HANDLE First, HANDLE Second)
+    {
+        using Compare_t = BOOL(WINAPI*)(HANDLE, HANDLE);
+        static const Compare_t compare{reinterpret_cast<Compare_t>(
+            GetProcAddress(GetModuleHandleW(L"kernelbase.dll"), "CompareObjectHandles"))};
+        return !compare || compare(First, Second);
+    }
+
+    //! @brief Hand a routine to a worker (requires the lock)
+    void Queue(std::shared_ptr<Task> const& Runnable)
+    {
+        Pending.push_back(Runnable);
+        if (!Sequential && Pending.size() > Idle)
+        {
+            Spawn();
+        }
+        Queued.notify_one();
+    }
+
+    //! @brief Start another worker (requires the lock)
+    void Spawn(void)
+    {
+        try
+        {
+            Workers.emplace_back([this] { Work(); });
+            ++Idle;
+        }
+        catch (std::system_error const&)
+        {
+            // The routine waits for a busy worker
+        }
+    }
+
+    void Work(void)
+    {
+        Exclusive lock(Lock);
+        for (;;)
+        {
+            while (Pending.empty() && !Stopping)
+            {
+                Queued.wait(lock);
+            }
+            if (Pending.empty())
+            {
+                return;
+            }
+            std::shared_ptr<Task> task{std::move(Pending.front())};
+            Pending.pop_front();
+            --Idle;
+            // Run the routine unlocked
+            lock.unlock();
+
+            task->Exit.store(task->Routine(task->Parameter), std::memory_order_release);
+            SetEvent(task->Done);
+            Returned.fetch_add(1, std::memory_order_acq_rel);
+            // The last reference closes the pool's handle, which must not be done locked
+            task.reset();
+
+            lock.lock();
+            if (++Idle == Workers.size() && Pending.empty())
+            {
+                Drained.notify_all();
+            }
+        }
+    }
+
+    const bool Sequential;
+    mutable std::mutex Lock;
+    //! @brief Signaled when a routine is queued, or the pool stops
+    std::condition_variable Queued;
+    //! @brief Signaled when the last running routine returns
+    std::condition_variable Drained;
+    std::vector<std::thread> Workers;
+    std::deque<std::shared_ptr<Task>> Pending;
+    //! @brief Threads by the handle returned to the caller, until it is closed
+    std::unordered_map<HANDLE, std::shared_ptr<Task>> Threads;
+    //! @brief Workers not running a routine
+    size_t Idle{};
+    DWORD NextId{FirstId_k};
+    bool Stopping{};
+    std::atomic<ULONGLONG> Returned{};
+};
+
+/**
+ * @brief Redirect the thread creation mocks to a worker pool
+ *
+ * @details Threads created while mounted run on the pool.
+ *          Other thread handles are passed to the real APIs.
+ *          CloseHandle() is guarded too, so it can't be mounted with a file system.
+ *
+ * @tparam CreateThread_t - Mock class of CreateThread()
+ * @tparam ResumeThread_t - Mock class of ResumeThread()
+ * @tparam GetExitCodeThread_t - Mock class of GetExitCodeThread()
+ * @tparam CloseHandle_t - Mock class of CloseHandle()
+ */
+template<typename CreateThread_t, typename ResumeThread_t, typename GetExitCodeThread_t, typename CloseHandle_t>
+class Mount
+{
+public:
+    explicit Mount(Pool& Workers)
+        : CreateGuard([&Workers](LPSECURITY_ATTRIBUTES, SIZE_T, LPTHREAD_START_ROUTINE Routine,
+                                 LPVOID Parameter, DWORD Flags, LPDWORD ThreadId) -> HANDLE
+            {
+                return Workers.Create(Routine, Parameter, Flags, ThreadId);
+            })
+        , ResumeGuard([&Workers](HANDLE Thread) -> DWORD
+            {
+                return Workers.Owns(Thread) ? Workers.Resume(Thread) : ResumeThread_t::Real(Thread);
+            })
+        , ExitCodeGuard([&Workers](HANDLE Thread, LPDWORD Code) -> BOOL
+            {
+                return Workers.Owns(Thread) ? Workers.ExitCode(Thread, Code) :
+                       GetExitCodeThread_t::Real(Thread, Code);
+            })
+        , CloseHandleGuard([&Workers](HANDLE Handle) -> BOOL
+            {
+                Workers.Close(Handle);
+                return CloseHandle_t::Real(Handle);
+            })
+    {
+    }
+
+private:
+    typename CreateThread_t::Guard CreateGuard;
+    typename ResumeThread_t::Guard ResumeGuard;
+    typename GetExitCodeThread_t::Guard ExitCodeGuard;
+    typename CloseHandle_t::Guard CloseHandleGuard;
+};
+
+} // namespace threads
+} // namespace ffmock